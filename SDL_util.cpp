@@ -3,10 +3,14 @@
 #include <SDL_image.h>
 #include <SDL_ttf.h>
 #include <cstdio>
+#include "rendererprobe.h"
 
+// the render driver picked on this machine, so it is only probed once
+const std::string RENDERER_FILE = "renderer.cfg";
 
-// Start up SDL, create a *window* and a *renderer*
-bool Screen::init(SDL_Window* &window, SDL_Renderer* &renderer) {
+
+// Start up SDL, create a *window* and a *renderer*, synced to the display's refresh if *vsync*
+bool Screen::init(SDL_Window* &window, SDL_Renderer* &renderer, bool vsync /*= true*/, const std::string &driver /*= ""*/) {
     bool success = true;
 
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
@@ -24,8 +28,8 @@ bool Screen::init(SDL_Window* &window, SDL_Renderer* &renderer) {
             printf("Failed to create window. SDL Error: %s\n", SDL_GetError());
             success  = false;
         } else {
-            // Create hardware-accelerated, vsynced renderer for window
-            renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+            // Create the best renderer for window, vsynced unless the caller paces frames itself
+            renderer = createBestRenderer(window, vsync, driver, RENDERER_FILE);
             if (renderer == nullptr) {
                 printf("Failed to create renderer. SDL Error: %s\n", SDL_GetError());
                 success = false;
@@ -51,6 +55,14 @@ bool Screen::init(SDL_Window* &window, SDL_Renderer* &renderer) {
     return success;
 }
 
+int Screen::refreshRate(SDL_Window *window) const {
+    SDL_DisplayMode mode;
+    if (SDL_GetWindowDisplayMode(window, &mode) != 0 || mode.refresh_rate <= 0) {
+        return 60;
+    }
+    return mode.refresh_rate;
+}
+
 void Screen::close(SDL_Window* &window, SDL_Renderer* &renderer) {
     SDL_DestroyRenderer(renderer);
     renderer = nullptr;
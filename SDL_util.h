@@ -2,14 +2,19 @@
 #define SDL_UTIL_H
 
 #include <SDL.h>
+#include <string>
 
 class Screen{
     public:
         const int SCREEN_WIDTH = 1897;
         const int SCREEN_HEIGHT = 720;
 
-        // Start up SDL, create a *window* and a *renderer*
-        bool init(SDL_Window* &window, SDL_Renderer* &renderer);
+        // Start up SDL, create a *window* and a *renderer*, synced to the display's refresh if *vsync*.
+        // The render driver is *driver* if named, else the fastest one found on this machine.
+        bool init(SDL_Window* &window, SDL_Renderer* &renderer, bool vsync = true, const std::string &driver = "");
+
+        // The refresh rate of the display *window* is on, or 60 if it is unknown
+        int refreshRate(SDL_Window *window) const;
 
         void close(SDL_Window* &window, SDL_Renderer* &renderer);
 
@@ -0,0 +1,59 @@
+#include "assetloader.h"
+#include <SDL_image.h>
+#include <algorithm>
+#include <cstdio>
+
+AssetLoader::AssetLoader(const std::vector<std::string> &paths, unsigned int nThreads /*= 0*/)
+    : mPaths(paths), mSurfaces(paths.size(), nullptr), mNext(0), mDecoded(0) {
+    if (nThreads == 0) {
+        nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    nThreads = std::min<size_t>(nThreads, paths.size());
+    for (unsigned int i = 0; i < nThreads; ++i) {
+        mWorkers.emplace_back(&AssetLoader::work, this);
+    }
+}
+
+AssetLoader::~AssetLoader() {
+    join();
+    for (auto surface: mSurfaces) {
+        SDL_FreeSurface(surface);
+    }
+}
+
+// Each worker claims the next undecoded path until none are left
+void AssetLoader::work() {
+    for (size_t i = mNext++; i < mPaths.size(); i = mNext++) {
+        mSurfaces[i] = IMG_Load(mPaths[i].c_str());
+        if (mSurfaces[i] == nullptr) {
+            printf("Failed to load image %s. IMG Error: %s\n", mPaths[i].c_str(), IMG_GetError());
+        }
+        mDecoded++;
+    }
+}
+
+void AssetLoader::join() {
+    for (auto &worker: mWorkers) {
+        worker.join();
+    }
+    mWorkers.clear();
+}
+
+size_t AssetLoader::decoded() const {
+    return mDecoded;
+}
+
+size_t AssetLoader::size() const {
+    return mPaths.size();
+}
+
+bool AssetLoader::done() const {
+    return mDecoded == mPaths.size();
+}
+
+std::vector<SDL_Surface*> AssetLoader::take() {
+    join();
+    std::vector<SDL_Surface*> surfaces;
+    surfaces.swap(mSurfaces);
+    return surfaces;
+}
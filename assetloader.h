@@ -0,0 +1,44 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <SDL.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Decodes image files into surfaces on a pool of worker threads.
+ *
+ * Decoding needs no renderer, so it can run on every core while the render
+ * thread shows progress; the render thread then takes the surfaces and creates
+ * its textures from them in one go.
+ */
+class AssetLoader {
+    public:
+        // Start decoding *paths* on *nThreads* workers, or one per core if 0
+        AssetLoader(const std::vector<std::string> &paths, unsigned int nThreads = 0);
+        // Waits for the workers and frees any surfaces not taken
+        ~AssetLoader();
+
+        // Number of files decoded so far, failed ones included
+        size_t decoded() const;
+        size_t size() const;
+        bool done() const;
+
+        // Wait for every file and hand over the surfaces, in the order of the
+        // paths; failed files give nullptr. The caller frees the surfaces.
+        std::vector<SDL_Surface*> take();
+
+    private:
+        std::vector<std::string> mPaths;
+        std::vector<SDL_Surface*> mSurfaces;
+        std::vector<std::thread> mWorkers;
+        std::atomic<size_t> mNext;
+        std::atomic<size_t> mDecoded;
+
+        void work();
+        void join();
+};
+
+#endif // ASSETLOADER_H
@@ -0,0 +1,124 @@
+#include "assetpack.h"
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+AssetPack::AssetPack() {
+    mData = nullptr;
+    mSize = 0;
+#ifdef _WIN32
+    mFile = mMapping = nullptr;
+#endif
+}
+
+AssetPack::~AssetPack() {
+    close();
+}
+
+bool AssetPack::open(const std::string &path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+    mFile = file;
+    mMapping = mapping;
+    mData = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    mSize = (size_t)size.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            mData = (const uint8_t*)data;
+            mSize = info.st_size;
+        }
+    }
+    // the mapping stays valid without the descriptor
+    ::close(fd);
+#endif
+    if (mData == nullptr) {
+        close();
+        return false;
+    }
+
+    // check the header and every entry before trusting any of them
+    const PackHeader *header = (const PackHeader*)mData;
+    if (mSize < sizeof(PackHeader) || memcmp(header->magic, PACK_MAGIC, 4) != 0 || header->version != PACK_VERSION
+        || header->count > (mSize - sizeof(PackHeader)) / sizeof(PackEntry)) {
+        printf("%s is not a valid asset pack.\n", path.c_str());
+        close();
+        return false;
+    }
+    const PackEntry *entries = (const PackEntry*)(mData + sizeof(PackHeader));
+    for (uint32_t i = 0; i < header->count; ++i) {
+        const PackEntry &entry = entries[i];
+        uint64_t nBytes = (uint64_t)entry.pitch * entry.height;
+        if (entry.pitch < entry.width * 4 || entry.offset > mSize || nBytes > mSize - entry.offset) {
+            printf("Asset pack %s has a damaged entry.\n", path.c_str());
+            close();
+            return false;
+        }
+        mNames.push_back(std::string(entry.name, strnlen(entry.name, sizeof(entry.name))));
+        mImages.push_back({(int)entry.width, (int)entry.height, (int)entry.pitch, mData + entry.offset});
+    }
+    return true;
+}
+
+void AssetPack::close() {
+#ifdef _WIN32
+    if (mData != nullptr) {
+        UnmapViewOfFile(mData);
+    }
+    if (mMapping != nullptr) {
+        CloseHandle(mMapping);
+    }
+    if (mFile != nullptr) {
+        CloseHandle(mFile);
+    }
+    mFile = mMapping = nullptr;
+#else
+    if (mData != nullptr) {
+        munmap((void*)mData, mSize);
+    }
+#endif
+    mData = nullptr;
+    mSize = 0;
+    mNames.clear();
+    mImages.clear();
+}
+
+const PackImage *AssetPack::find(const std::string &name) const {
+    for (size_t i = 0; i < mNames.size(); ++i) {
+        if (mNames[i] == name) {
+            return &mImages[i];
+        }
+    }
+    return nullptr;
+}
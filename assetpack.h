@@ -0,0 +1,69 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <SDL.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A packed archive of images already decoded to RGBA32, with any color key
+ * already turned into alpha, written by packtool.
+ *
+ * The archive is memory-mapped, so opening it reads only the index and the
+ * pixels are handed to the renderer straight from the mapping.
+ *
+ * Layout, little-endian: a PackHeader, *count* PackEntry records, then each
+ * image's rows at its entry's offset, 16-byte aligned.
+ */
+struct PackHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct PackEntry {
+    char name[112];
+    uint32_t width;
+    uint32_t height;
+    uint32_t pitch;
+    uint32_t reserved;
+    uint64_t offset;
+};
+
+const char PACK_MAGIC[4] = {'P', 'T', 'P', 'K'};
+const uint32_t PACK_VERSION = 1;
+
+// One image in a mapped pack; *pixels* points into the mapping
+struct PackImage {
+    int width;
+    int height;
+    int pitch;
+    const void *pixels;
+};
+
+class AssetPack {
+    public:
+        AssetPack();
+        ~AssetPack();
+
+        // Map the archive at *path*; false if it is missing or not a valid pack
+        bool open(const std::string &path);
+        void close();
+
+        // The image stored under *name*, or nullptr
+        const PackImage *find(const std::string &name) const;
+
+    private:
+        const uint8_t *mData;
+        size_t mSize;
+        std::vector<std::string> mNames;
+        std::vector<PackImage> mImages;
+#ifdef _WIN32
+        void *mFile;
+        void *mMapping;
+#endif
+};
+
+#endif // ASSETPACK_H
@@ -0,0 +1,150 @@
+#include "calibration.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// seconds between beats
+const double dBeatInterval = 0.6;
+// beats in each phase; the first few let the player find the pulse and are not scored
+const int nPhaseBeats = 16;
+const int nLeadInBeats = 4;
+// silence between the audio and the visual phase
+const double dPhaseGap = 3 * dBeatInterval;
+// fewer usable taps than this in a phase and the phase is not trusted
+const size_t nMinTaps = 6;
+
+const double dClickLength = 0.03;
+const double dFlashLength = 0.08;
+
+bool LatencyProfile::load(const std::string &path) {
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return false;
+    }
+    double dAudio, dVisual;
+    bool success = fscanf(file, "audio_offset %lf visual_offset %lf", &dAudio, &dVisual) == 2;
+    fclose(file);
+
+    if (success) {
+        dAudioOffset = dAudio;
+        dVisualOffset = dVisual;
+    }
+    return success;
+}
+
+bool LatencyProfile::save(const std::string &path) const {
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        printf("Failed to save latency profile %s.\n", path.c_str());
+        return false;
+    }
+    fprintf(file, "audio_offset %.6f\nvisual_offset %.6f\n", dAudioOffset, dVisualOffset);
+    fclose(file);
+    return true;
+}
+
+double LatencyProfile::displayTime(double dAudioTime) const {
+    return dAudioTime + dVisualOffset - dAudioOffset;
+}
+
+double robustOffset(std::vector<double> offsets) {
+    if (offsets.empty()) {
+        return 0.0;
+    }
+    auto median = [](std::vector<double> v) {
+        std::sort(v.begin(), v.end());
+        size_t n = v.size();
+        return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+    };
+
+    double dMedian = median(offsets);
+    std::vector<double> deviations;
+    for (double d: offsets) {
+        deviations.push_back(std::fabs(d - dMedian));
+    }
+    // 1.4826 scales the MAD to a standard deviation for normally distributed taps
+    double dLimit = 3.0 * 1.4826 * median(deviations);
+
+    std::vector<double> inliers;
+    for (double d: offsets) {
+        if (std::fabs(d - dMedian) <= dLimit) {
+            inliers.push_back(d);
+        }
+    }
+    return median(inliers);
+}
+
+Calibration::Calibration() : mStart(-1.0) {}
+
+void Calibration::start(double dTime) {
+    mAudioTaps.clear();
+    mVisualTaps.clear();
+    mStart.store(dTime, std::memory_order_release);
+}
+
+bool Calibration::started() const {
+    return mStart.load(std::memory_order_acquire) >= 0.0;
+}
+
+double Calibration::beatTime(int k) const {
+    double dStart = mStart.load(std::memory_order_acquire);
+    if (k < nPhaseBeats) {
+        return dStart + k * dBeatInterval;
+    }
+    return dStart + nPhaseBeats * dBeatInterval + dPhaseGap + (k - nPhaseBeats) * dBeatInterval;
+}
+
+double Calibration::click(double dTime) const {
+    double dStart = mStart.load(std::memory_order_relaxed);
+    if (dStart < 0.0 || dTime < dStart) {
+        return 0.0;
+    }
+    int k = (int)((dTime - dStart) / dBeatInterval);
+    double dSince = dTime - dStart - k * dBeatInterval;
+    if (k >= nPhaseBeats || dSince >= dClickLength) {
+        return 0.0;
+    }
+    // short decaying 1 kHz blip
+    return 0.5 * std::sin(4.0 * std::acos(0.0) * 1000.0 * dSince) * std::exp(-dSince / 0.006);
+}
+
+bool Calibration::flash(double dTime) const {
+    if (!started()) {
+        return false;
+    }
+    double dVisualStart = beatTime(nPhaseBeats);
+    if (dTime < dVisualStart) {
+        return false;
+    }
+    int k = (int)((dTime - dVisualStart) / dBeatInterval);
+    return k < nPhaseBeats && dTime - dVisualStart - k * dBeatInterval < dFlashLength;
+}
+
+void Calibration::tap(double dTime) {
+    if (!started()) {
+        return;
+    }
+    // which phase the tap belongs to, then the nearest beat in it
+    bool bVisual = dTime >= beatTime(nPhaseBeats) - dBeatInterval / 2.0;
+    double dPhaseStart = beatTime(bVisual ? nPhaseBeats : 0);
+    int k = (int)std::floor((dTime - dPhaseStart) / dBeatInterval + 0.5);
+    if (k < nLeadInBeats || k >= nPhaseBeats) {
+        return;
+    }
+
+    double dOffset = dTime - (dPhaseStart + k * dBeatInterval);
+    (bVisual ? mVisualTaps : mAudioTaps).push_back(dOffset);
+}
+
+bool Calibration::done(double dTime) const {
+    return started() && dTime > beatTime(2 * nPhaseBeats - 1) + dBeatInterval;
+}
+
+bool Calibration::result(LatencyProfile &profile) const {
+    if (mAudioTaps.size() < nMinTaps || mVisualTaps.size() < nMinTaps) {
+        return false;
+    }
+    profile.dAudioOffset = robustOffset(mAudioTaps);
+    profile.dVisualOffset = robustOffset(mVisualTaps);
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Measured output latencies, in seconds of audio time
+struct LatencyProfile {
+    // from a note being rendered to the player hearing it
+    double dAudioOffset = 0.0;
+    // from a frame being drawn to the player seeing it
+    double dVisualOffset = 0.0;
+
+    bool load(const std::string &path);
+    bool save(const std::string &path) const;
+
+    // The audio time a frame drawn at *dAudioTime* should show, so that what is
+    // on screen lines up with what is being heard when the frame appears
+    double displayTime(double dAudioTime) const;
+};
+
+// Median of *offsets* after dropping outliers more than 3 scaled MADs from the median
+double robustOffset(std::vector<double> offsets);
+
+/**
+ * Click-track calibration: the player taps along to clicks they hear, then to
+ * flashes they see, and the tap offsets give the audio and visual latency.
+ *
+ * The schedule is fixed once start() is called, so the audio thread can read
+ * click() without locks while the UI thread feeds taps.
+ */
+class Calibration {
+    public:
+        Calibration();
+
+        // UI thread: begin the click track at audio time *dTime*
+        void start(double dTime);
+        bool started() const;
+
+        // Audio thread: the click sample to mix in at *dTime*
+        double click(double dTime) const;
+
+        // UI thread: whether the visual beat marker is lit at *dTime*
+        bool flash(double dTime) const;
+
+        // UI thread: the player tapped at audio time *dTime*
+        void tap(double dTime);
+
+        // Whether both phases are over at *dTime*
+        bool done(double dTime) const;
+
+        // Estimate the profile from the taps; false if too few taps were usable
+        bool result(LatencyProfile &profile) const;
+
+    private:
+        std::atomic<double> mStart;
+        std::vector<double> mAudioTaps;
+        std::vector<double> mVisualTaps;
+
+        // Beat *k* of the track, counting the audio phase then the visual phase
+        double beatTime(int k) const;
+};
+
+#endif // CALIBRATION_H
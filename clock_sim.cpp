@@ -0,0 +1,115 @@
+// Offline check of ClockSync against jittered block stamps, with no audio device.
+//
+// usage: clock_sim [seconds] [--jitter MS] [--drift PPM]
+//
+// A simulated sound card plays 512-sample blocks at 44100 Hz, running *drift*
+// ppm off the performance counter, and each block is stamped up to *jitter* ms
+// late, uniformly, as a scheduled audio thread would stamp it. A 60 Hz renderer
+// reads the filtered clock every frame. One JSON object per line gives, after the
+// loop has settled, the error against the true audio time, split into its mean,
+// which is the stamps' average lateness and is calibrated out with the rest of the
+// output latency, and its spread; and the frame-to-frame noise, how far each
+// frame's step differs from the true 1/60 s, e.g.
+//   clock_sim > clock_output.txt
+// The jitter is seeded, so runs are repeatable.
+#include <SDL.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "clocksync.h"
+
+const unsigned int SAMPLE_RATE = 44100;
+const unsigned int BLOCK_SAMPLES = 512;
+const double FRAME_TIME = 1.0 / 60.0;
+// seconds the loop gets to settle before it is measured
+const double SETTLE_TIME = 10.0;
+
+struct SimResult {
+    double dErrorMean;
+    double dErrorSd;
+    double dNoiseRms;
+    double dNoiseMax;
+};
+
+SimResult simulate(double dSeconds, double dJitter, double dDrift, unsigned int nSeed) {
+    double dFrequency = (double)SDL_GetPerformanceFrequency();
+    ClockSync clock(SAMPLE_RATE);
+    std::mt19937 random(nSeed);
+    std::uniform_real_distribution<double> lateness(0.0, dJitter);
+
+    // the card's true seconds per sample, on the counter's clock
+    double dPeriod = (1.0 + dDrift * 1e-6) / SAMPLE_RATE;
+    uint64_t nSamples = 0;
+    double dNextBlock = BLOCK_SAMPLES * dPeriod;
+
+    SimResult result{0.0, 0.0, 0.0, 0.0};
+    double dErrorSquares = 0.0;
+    int nMeasured = 0;
+    double dLastEstimate = 0.0;
+    bool bHaveLast = false;
+    for (double dNow = FRAME_TIME; dNow < SETTLE_TIME + dSeconds; dNow += FRAME_TIME) {
+        // every block finished by now, stamped late by its jitter
+        while (dNextBlock <= dNow) {
+            nSamples += BLOCK_SAMPLES;
+            double dStamp = dNextBlock + lateness(random);
+            clock.update(nSamples, (uint64_t)(dStamp * dFrequency));
+            dNextBlock += BLOCK_SAMPLES * dPeriod;
+        }
+
+        double dEstimate = clock.timeAt((uint64_t)(dNow * dFrequency));
+        double dTrue = dNow / dPeriod / SAMPLE_RATE;
+        if (dNow >= SETTLE_TIME && bHaveLast) {
+            double dError = dEstimate - dTrue;
+            double dNoise = (dEstimate - dLastEstimate) - FRAME_TIME / dPeriod / SAMPLE_RATE;
+            result.dErrorMean += dError;
+            dErrorSquares += dError * dError;
+            result.dNoiseRms += dNoise * dNoise;
+            result.dNoiseMax = std::max(result.dNoiseMax, std::fabs(dNoise));
+            ++nMeasured;
+        }
+        dLastEstimate = dEstimate;
+        bHaveLast = clock.locked();
+    }
+    if (nMeasured > 0) {
+        result.dErrorMean /= nMeasured;
+        result.dErrorSd = std::sqrt(std::max(dErrorSquares / nMeasured - result.dErrorMean * result.dErrorMean, 0.0));
+        result.dNoiseRms = std::sqrt(result.dNoiseRms / nMeasured);
+    }
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    double dSeconds = 60.0;
+    std::vector<double> jitters = {0.0, 1.0, 3.0, 5.0};
+    std::vector<double> drifts = {0.0, 100.0};
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--jitter" && i + 1 < argc) {
+            jitters = {atof(argv[++i])};
+        }
+        else if (std::string(argv[i]) == "--drift" && i + 1 < argc) {
+            drifts = {atof(argv[++i])};
+        }
+        else {
+            dSeconds = atof(argv[i]);
+        }
+    }
+    if (dSeconds <= 0.0) {
+        printf("usage: %s [seconds] [--jitter MS] [--drift PPM]\n", argv[0]);
+        return 1;
+    }
+
+    for (double dDrift: drifts) {
+        for (double dJitter: jitters) {
+            SimResult result = simulate(dSeconds, dJitter / 1000.0, dDrift, 1);
+            printf("{\"jitter_ms\": %.2f, \"drift_ppm\": %.1f, \"seconds\": %.1f, "
+                   "\"error_mean_ms\": %.4f, \"error_sd_ms\": %.4f, \"frame_noise_rms_ms\": %.4f, \"frame_noise_max_ms\": %.4f}\n",
+                   dJitter, dDrift, dSeconds, result.dErrorMean * 1000.0, result.dErrorSd * 1000.0,
+                   result.dNoiseRms * 1000.0, result.dNoiseMax * 1000.0);
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
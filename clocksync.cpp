@@ -0,0 +1,82 @@
+#include "clocksync.h"
+#include <SDL.h>
+#include <cmath>
+
+// errors beyond this mean the audio stalled or the loop lost track, so start over
+const double dMaxClockError = 0.05;
+const double dTwoPi = 4.0 * std::acos(0.0);
+// gaps between updates beyond this are too long for the loop to stay stable
+const double dMaxClockInterval = 0.25;
+
+ClockSync::ClockSync(unsigned int nSampleRate, double dBandwidth /*= 0.5*/) {
+    mSampleRate = nSampleRate;
+    mBandwidth = dBandwidth;
+    mCounterPeriod = 1.0 / (double)SDL_GetPerformanceFrequency();
+    mLocked = false;
+    mLastSamples = 0;
+    mT0 = mS0 = 0.0;
+    mPeriod = 1.0 / (double)nSampleRate;
+}
+
+void ClockSync::reset(uint64_t nSamples, double dTime) {
+    mLocked = true;
+    mLastSamples = nSamples;
+    mT0 = dTime;
+    mS0 = (double)nSamples;
+    mPeriod = 1.0 / (double)mSampleRate;
+}
+
+void ClockSync::update(uint64_t nSamples, uint64_t nCounter) {
+    // nothing published yet
+    if (nCounter == 0) {
+        return;
+    }
+    double dTime = (double)nCounter * mCounterPeriod;
+    if (!mLocked || nSamples < mLastSamples) {
+        reset(nSamples, dTime);
+        return;
+    }
+    if (nSamples == mLastSamples) {
+        return;
+    }
+
+    // compare the block's stamp with where the filtered line predicts it
+    double dSamples = (double)nSamples - mS0;
+    double dPredicted = mT0 + dSamples * mPeriod;
+    double dError = dTime - dPredicted;
+    double dInterval = dSamples * mPeriod;
+    if (std::fabs(dError) > dMaxClockError || dInterval > dMaxClockInterval) {
+        reset(nSamples, dTime);
+        return;
+    }
+
+    // critically damped second-order loop, gains scaled to the time since the last update
+    double w = dTwoPi * mBandwidth * dInterval;
+    mT0 = dPredicted + std::sqrt(2.0) * w * dError;
+    mS0 = (double)nSamples;
+    mPeriod += w * w * dError / dSamples;
+    mLastSamples = nSamples;
+}
+
+double ClockSync::timeAt(uint64_t nCounter) const {
+    if (!mLocked) {
+        return 0.0;
+    }
+    double dTime = (double)nCounter * mCounterPeriod;
+    return (mS0 + (dTime - mT0) / mPeriod) / (double)mSampleRate;
+}
+
+double ClockSync::now() const {
+    return timeAt(SDL_GetPerformanceCounter());
+}
+
+double ClockSync::timeAtTicks(uint32_t nTicks) const {
+    // ticks only have a millisecond's resolution, so count back from now
+    // rather than converting between the two clocks' origins
+    uint32_t nAge = SDL_GetTicks() - nTicks;
+    return now() - nAge / 1000.0;
+}
+
+bool ClockSync::locked() const {
+    return mLocked;
+}
@@ -0,0 +1,52 @@
+#ifndef CLOCKSYNC_H
+#define CLOCKSYNC_H
+
+#include <cstdint>
+
+/**
+ * Estimates the audio clock at any moment from the block timestamps the sound
+ * machine publishes.
+ *
+ * Blocks are stamped with SDL's performance counter when they are queued, so the
+ * stamps jitter with thread scheduling. A second-order delay-locked loop filters
+ * them into a straight line of samples against counter ticks, which the renderer
+ * can read every frame without locking and without the jumps of raw block times.
+ */
+class ClockSync {
+    public:
+        // *dBandwidth* in Hz: lower is smoother, higher follows rate changes faster
+        ClockSync(unsigned int nSampleRate, double dBandwidth = 0.5);
+
+        // Feed the latest published (samples, counter) pair; repeated pairs are ignored
+        void update(uint64_t nSamples, uint64_t nCounter);
+
+        // Audio time in seconds at performance counter *nCounter*
+        double timeAt(uint64_t nCounter) const;
+
+        // Audio time in seconds right now
+        double now() const;
+
+        // Audio time in seconds at *nTicks*, in the milliseconds of SDL_GetTicks()
+        // that SDL stamps events with
+        double timeAtTicks(uint32_t nTicks) const;
+
+        // Whether at least one block has been seen
+        bool locked() const;
+
+    private:
+        unsigned int mSampleRate;
+        double mBandwidth;
+        double mCounterPeriod;
+
+        bool mLocked;
+        uint64_t mLastSamples;
+        // filtered line: at counter time mT0 (seconds) the clock was at mS0 samples
+        double mT0;
+        double mS0;
+        // filtered seconds per sample
+        double mPeriod;
+
+        void reset(uint64_t nSamples, double dTime);
+};
+
+#endif // CLOCKSYNC_H
@@ -0,0 +1,50 @@
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Passes events from one producer thread to one consumer thread without locks,
+ * so neither side ever waits on the other.
+ *
+ * A fixed ring of *N* slots; push() fails rather than blocks when it is full,
+ * and pop() fails when it is empty. Each side only writes its own index, so an
+ * empty check costs the consumer one atomic load, cheap enough for every sample
+ * of the audio callback.
+ */
+template<class T, size_t N>
+class EventQueue {
+    public:
+        EventQueue() : mHead(0), mTail(0) {}
+
+        // Producer: queue *event*; false if the consumer has fallen N events behind
+        bool push(const T &event) {
+            size_t nTail = mTail.load(std::memory_order_relaxed);
+            if (nTail - mHead.load(std::memory_order_acquire) == N) {
+                return false;
+            }
+            mSlots[nTail % N] = event;
+            mTail.store(nTail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer: take the oldest event into *event*; false if there is none
+        bool pop(T &event) {
+            size_t nHead = mHead.load(std::memory_order_relaxed);
+            if (nHead == mTail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            event = mSlots[nHead % N];
+            mHead.store(nHead + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        T mSlots[N];
+        // counts of events popped and pushed; they only ever grow
+        std::atomic<size_t> mHead;
+        std::atomic<size_t> mTail;
+};
+
+#endif // EVENTQUEUE_H
@@ -0,0 +1,38 @@
+#include "fixedstep.h"
+#include <cmath>
+
+FixedStep::FixedStep(double dStep, int nMaxSteps /*= 16*/) {
+    mStep = dStep;
+    mMaxSteps = nMaxSteps;
+    mStarted = false;
+    mTime = 0.0;
+    mTaken = 0;
+}
+
+int FixedStep::advance(double dTime) {
+    if (!mStarted) {
+        mStarted = true;
+        mTime = dTime;
+        mTaken = 1;
+        return 1;
+    }
+
+    int nDue = dTime > mTime ? (int)std::floor((dTime - mTime) / mStep) : 0;
+    // after a stall, skip ahead rather than replaying it all in one frame
+    if (nDue > mMaxSteps) {
+        mTime += (nDue - mMaxSteps) * mStep;
+        nDue = mMaxSteps;
+    }
+    mTime += nDue * mStep;
+    mTaken = nDue;
+    return nDue;
+}
+
+double FixedStep::stepTime(int k) const {
+    return mTime - (mTaken - 1 - k) * mStep;
+}
+
+double FixedStep::alpha(double dTime) const {
+    double dAlpha = (dTime - mTime) / mStep;
+    return dAlpha < 0.0 ? 0.0 : (dAlpha > 1.0 ? 1.0 : dAlpha);
+}
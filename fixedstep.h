@@ -0,0 +1,34 @@
+#ifndef FIXEDSTEP_H
+#define FIXEDSTEP_H
+
+/**
+ * Turns a continuous clock into fixed simulation steps.
+ *
+ * Each frame, advance() reports how many whole steps have come due since the
+ * last one, and alpha() how far the clock is into the next step, for
+ * interpolating what is drawn. The result is the same whatever the frame rate.
+ */
+class FixedStep {
+    public:
+        // *dStep* in seconds; falling more than *nMaxSteps* behind drops the backlog
+        FixedStep(double dStep, int nMaxSteps = 16);
+
+        // Take every step due by *dTime*; returns how many were taken
+        int advance(double dTime);
+
+        // Time of step *k* of the ones just taken, 0 being the earliest
+        double stepTime(int k) const;
+
+        // How far *dTime* is past the last step taken, in steps, from 0 to 1
+        double alpha(double dTime) const;
+
+    private:
+        double mStep;
+        int mMaxSteps;
+        bool mStarted;
+        // time of the last step taken, and how many the last advance() took
+        double mTime;
+        int mTaken;
+};
+
+#endif // FIXEDSTEP_H
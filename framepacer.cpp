@@ -0,0 +1,134 @@
+#include "framepacer.h"
+#include <algorithm>
+
+// late latch starts this much earlier than the draw time alone asks for
+const double dLatchMargin = 0.001;
+// SDL_Delay can overshoot by about a scheduler tick, so the last stretch is spun
+const double dSpinTime = 0.002;
+const size_t nLatencySamples = 128;
+
+bool parsePresentMode(const std::string &name, PresentMode &mode) {
+    if (name == "vsync") {
+        mode = PRESENT_VSYNC;
+    }
+    else if (name == "limit") {
+        mode = PRESENT_LIMIT;
+    }
+    else if (name == "late") {
+        mode = PRESENT_LATE_LATCH;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+FramePacer::FramePacer(PresentMode mode, double dRate) : mLatencies(nLatencySamples, 0.0) {
+    mMode = mode;
+    mCounterFrequency = (double)SDL_GetPerformanceFrequency();
+    mPeriod = (Uint64)(mCounterFrequency / dRate);
+    mLastPresent = mNextFrame = mFrameStart = SDL_GetPerformanceCounter();
+    mWorkEstimate = mLastWork = 0.0;
+    mPendingInput = 0;
+    mLatencyCount = 0;
+}
+
+bool FramePacer::vsync(PresentMode mode) {
+    return mode != PRESENT_LIMIT;
+}
+
+void FramePacer::waitUntil(Uint64 nCounter) const {
+    Uint64 nNow = SDL_GetPerformanceCounter();
+    if (nNow >= nCounter) {
+        return;
+    }
+    double dRemaining = (nCounter - nNow) / mCounterFrequency;
+    if (dRemaining > dSpinTime) {
+        SDL_Delay((Uint32)((dRemaining - dSpinTime) * 1000.0));
+    }
+    while (SDL_GetPerformanceCounter() < nCounter) {
+    }
+}
+
+void FramePacer::wait() {
+    if (mMode == PRESENT_LIMIT) {
+        waitUntil(mNextFrame);
+        mNextFrame += mPeriod;
+        // after a stall, start a new cadence rather than rushing frames to catch up
+        Uint64 nNow = SDL_GetPerformanceCounter();
+        if (nNow > mNextFrame) {
+            mNextFrame = nNow + mPeriod;
+        }
+    }
+    else if (mMode == PRESENT_LATE_LATCH) {
+        Uint64 nLead = (Uint64)(mWorkEstimate + dLatchMargin * mCounterFrequency);
+        Uint64 nRefresh = mLastPresent + mPeriod;
+        if (nRefresh > nLead) {
+            waitUntil(nRefresh - nLead);
+        }
+    }
+    mFrameStart = SDL_GetPerformanceCounter();
+}
+
+void FramePacer::input(Uint32 nTimestamp) {
+    // SDL stamps events in ms of SDL_GetTicks(), so count back from now
+    Uint64 nAge = (Uint64)((SDL_GetTicks() - nTimestamp) / 1000.0 * mCounterFrequency);
+    Uint64 nNow = SDL_GetPerformanceCounter();
+    Uint64 nEvent = nNow > nAge ? nNow - nAge : 1;
+    if (mPendingInput == 0 || nEvent < mPendingInput) {
+        mPendingInput = nEvent;
+    }
+}
+
+void FramePacer::present(SDL_Renderer *renderer) {
+    Uint64 nWorkEnd = SDL_GetPerformanceCounter();
+    SDL_RenderPresent(renderer);
+    mLastPresent = SDL_GetPerformanceCounter();
+
+    // draw times rise at once, so a slow frame is not followed by a missed refresh, and fall slowly
+    double dWork = (double)(nWorkEnd - mFrameStart);
+    mLastWork = dWork;
+    mWorkEstimate = dWork > mWorkEstimate ? dWork : mWorkEstimate + 0.05 * (dWork - mWorkEstimate);
+
+    if (mPendingInput != 0) {
+        mLatencies[mLatencyCount++ % nLatencySamples] = (mLastPresent - mPendingInput) * 1000.0 / mCounterFrequency;
+        mPendingInput = 0;
+    }
+}
+
+double FramePacer::workTime() const {
+    return mLastWork / mCounterFrequency;
+}
+
+double FramePacer::inputLatency() const {
+    size_t n = std::min(mLatencyCount, nLatencySamples);
+    if (n == 0) {
+        return 0.0;
+    }
+    double dTotal = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        dTotal += mLatencies[i];
+    }
+    return dTotal / n;
+}
+
+double FramePacer::inputLatencyP99() const {
+    size_t n = std::min(mLatencyCount, nLatencySamples);
+    if (n == 0) {
+        return 0.0;
+    }
+    std::vector<double> sorted(mLatencies.begin(), mLatencies.begin() + n);
+    std::sort(sorted.begin(), sorted.end());
+    return sorted[std::min(n - 1, (size_t)(0.99 * n))];
+}
+
+const char *FramePacer::name() const {
+    switch (mMode) {
+        case PRESENT_LIMIT:
+            return "limit";
+        case PRESENT_LATE_LATCH:
+            return "late latch";
+        default:
+            return "vsync";
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <SDL.h>
+#include <string>
+#include <vector>
+
+enum PresentMode {
+    // present waits for the display's refresh
+    PRESENT_VSYNC,
+    // no vsync; frames start on a fixed cadence kept by sleeping then spinning
+    PRESENT_LIMIT,
+    // vsync, but the frame starts as late as it can and still make the next refresh
+    PRESENT_LATE_LATCH
+};
+
+// Parse "vsync", "limit" or "late" into *mode*; false if it is none of them
+bool parsePresentMode(const std::string &name, PresentMode &mode);
+
+/**
+ * Decides when each frame starts and presents it, and measures how long key
+ * events wait before a frame showing them is presented.
+ *
+ * With vsync alone, a frame is drawn right after the previous present and
+ * then waits for the refresh, so the input it read is up to a frame old when
+ * it appears. Late latch instead sleeps until the predicted refresh minus the
+ * time frames have recently taken to draw, then reads input and draws.
+ */
+class FramePacer {
+    public:
+        // *dRate* in frames per second: the display's refresh rate, or the limit
+        FramePacer(PresentMode mode, double dRate);
+
+        // Whether the renderer should be created with vsync
+        static bool vsync(PresentMode mode);
+
+        // Wait until the frame should start reading input
+        void wait();
+
+        // A key event stamped *nTimestamp* (SDL_GetTicks() ms) is shown by this frame
+        void input(Uint32 nTimestamp);
+
+        // Present the frame and record its timings
+        void present(SDL_Renderer *renderer);
+
+        // Seconds the last frame took from wait() returning to being handed to present
+        double workTime() const;
+
+        // Mean and 99th percentile, in ms, of the recent input-to-present times
+        double inputLatency() const;
+        double inputLatencyP99() const;
+
+        const char *name() const;
+
+    private:
+        PresentMode mMode;
+        double mCounterFrequency;
+        Uint64 mPeriod;
+        // when the last present returned, and when the next frame is due
+        Uint64 mLastPresent;
+        Uint64 mNextFrame;
+        Uint64 mFrameStart;
+        // smoothed and last time from starting a frame to presenting it, in counter ticks
+        double mWorkEstimate;
+        double mLastWork;
+        // the oldest key event waiting to be presented, or 0
+        Uint64 mPendingInput;
+
+        // ring of recent input-to-present times, in ms
+        std::vector<double> mLatencies;
+        size_t mLatencyCount;
+
+        // Sleep most of the way to *nCounter*, then spin the rest
+        void waitUntil(Uint64 nCounter) const;
+};
+
+#endif // FRAMEPACER_H
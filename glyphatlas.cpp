@@ -0,0 +1,169 @@
+#include "glyphatlas.h"
+#include <algorithm>
+#include <cstdio>
+
+// transparent gap around every glyph, so filtering never samples a neighbour
+const int nGlyphPadding = 1;
+const int nGlyphAtlasWidth = 512;
+
+GlyphAtlas::GlyphAtlas() {
+    mTexture = nullptr;
+    mWidth = mHeight = 0;
+    mLineSkip = 0;
+}
+
+GlyphAtlas::~GlyphAtlas() {
+    free();
+}
+
+void GlyphAtlas::free() {
+    if (mTexture != nullptr) {
+        SDL_DestroyTexture(mTexture);
+        mTexture = nullptr;
+        mWidth = mHeight = 0;
+    }
+    mGlyphs.clear();
+}
+
+bool GlyphAtlas::loaded() const {
+    return mTexture != nullptr;
+}
+
+bool GlyphAtlas::build(SDL_Renderer *renderer, TTF_Font *font) {
+    free();
+    if (font == nullptr) {
+        return false;
+    }
+    mLineSkip = TTF_FontLineSkip(font);
+
+    // render every glyph in white, so the vertex color tints it when drawn
+    SDL_Color white{0xFF, 0xFF, 0xFF, 0xFF};
+    std::vector<SDL_Surface*> rendered;
+    int x = 0, y = 0, nShelfHeight = 0;
+    for (int c = FIRST_GLYPH; c <= LAST_GLYPH; ++c) {
+        Glyph g{{0, 0, 0, 0}, 0, 0};
+        int minX, maxX, minY, maxY;
+        if (TTF_GlyphMetrics(font, c, &minX, &maxX, &minY, &maxY, &g.advance) == 0) {
+            g.offset = std::min(minX, 0);
+        }
+        SDL_Surface *surface = c == ' ' ? nullptr : TTF_RenderGlyph_Blended(font, c, white);
+        if (surface != nullptr) {
+            // glyphs all have the font's height, so one shelf fills up before the next starts
+            if (x + surface->w + 2 * nGlyphPadding > nGlyphAtlasWidth) {
+                x = 0;
+                y += nShelfHeight;
+                nShelfHeight = 0;
+            }
+            g.source = {x + nGlyphPadding, y + nGlyphPadding, surface->w, surface->h};
+            x += surface->w + 2 * nGlyphPadding;
+            nShelfHeight = std::max(nShelfHeight, surface->h + 2 * nGlyphPadding);
+        }
+        rendered.push_back(surface);
+        mGlyphs.push_back(g);
+    }
+    int nHeight = std::max(y + nShelfHeight, 1);
+
+    bool success = false;
+    SDL_Surface *atlas = SDL_CreateRGBSurfaceWithFormat(0, nGlyphAtlasWidth, nHeight, 32, SDL_PIXELFORMAT_RGBA32);
+    if (atlas == nullptr) {
+        printf("Failed to create glyph atlas surface. SDL Error: %s\n", SDL_GetError());
+    }
+    else {
+        SDL_FillRect(atlas, nullptr, 0);
+        for (size_t k = 0; k < rendered.size(); ++k) {
+            if (rendered[k] != nullptr) {
+                // copy the pixels, alpha included, rather than blending them in
+                SDL_SetSurfaceBlendMode(rendered[k], SDL_BLENDMODE_NONE);
+                SDL_Rect dst = mGlyphs[k].source;
+                SDL_BlitSurface(rendered[k], nullptr, atlas, &dst);
+            }
+        }
+
+        mTexture = SDL_CreateTextureFromSurface(renderer, atlas);
+        if (mTexture == nullptr) {
+            printf("Failed to create glyph atlas texture. SDL Error: %s\n", SDL_GetError());
+        }
+        else {
+            SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_BLEND);
+            mWidth = nGlyphAtlasWidth;
+            mHeight = nHeight;
+            success = true;
+        }
+        SDL_FreeSurface(atlas);
+    }
+
+    for (auto surface: rendered) {
+        SDL_FreeSurface(surface);
+    }
+    if (!success) {
+        mGlyphs.clear();
+    }
+    return success;
+}
+
+const GlyphAtlas::Glyph *GlyphAtlas::glyph(char c) const {
+    if (c < FIRST_GLYPH || c > LAST_GLYPH || mGlyphs.empty()) {
+        return nullptr;
+    }
+    return &mGlyphs[c - FIRST_GLYPH];
+}
+
+int GlyphAtlas::measure(const std::string &text) const {
+    int nWidth = 0;
+    for (char c: text) {
+        const Glyph *g = glyph(c);
+        if (g != nullptr) {
+            nWidth += g->advance;
+        }
+    }
+    return nWidth;
+}
+
+int GlyphAtlas::lineSkip() const {
+    return mLineSkip;
+}
+
+void GlyphAtlas::add(const std::string &text, int x, int y, SDL_Color color) {
+    if (mTexture == nullptr) {
+        return;
+    }
+    int nPen = x;
+    for (char c: text) {
+        if (c == '\n') {
+            nPen = x;
+            y += mLineSkip;
+            continue;
+        }
+        const Glyph *g = glyph(c);
+        if (g == nullptr) {
+            continue;
+        }
+        if (g->source.w > 0) {
+            float u0 = (float)g->source.x / mWidth;
+            float v0 = (float)g->source.y / mHeight;
+            float u1 = (float)(g->source.x + g->source.w) / mWidth;
+            float v1 = (float)(g->source.y + g->source.h) / mHeight;
+            float x0 = (float)(nPen + g->offset), y0 = (float)y;
+            float x1 = x0 + g->source.w, y1 = y0 + g->source.h;
+
+            int base = mVertices.size();
+            mVertices.push_back({{x0, y0}, color, {u0, v0}});
+            mVertices.push_back({{x1, y0}, color, {u1, v0}});
+            mVertices.push_back({{x1, y1}, color, {u1, v1}});
+            mVertices.push_back({{x0, y1}, color, {u0, v1}});
+            int quad[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+            mIndices.insert(mIndices.end(), quad, quad + 6);
+        }
+        nPen += g->advance;
+    }
+}
+
+int GlyphAtlas::flush(SDL_Renderer *renderer) {
+    if (mIndices.empty()) {
+        return 0;
+    }
+    SDL_RenderGeometry(renderer, mTexture, mVertices.data(), mVertices.size(), mIndices.data(), mIndices.size());
+    mVertices.clear();
+    mIndices.clear();
+    return 1;
+}
@@ -0,0 +1,67 @@
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <string>
+#include <vector>
+
+/**
+ * The printable ASCII glyphs of one font at one size, rasterized once into a
+ * single texture together with their metrics.
+ *
+ * Text is laid out from the cached metrics and queued as textured quads, and
+ * everything queued is drawn with one SDL_RenderGeometry call, so text that
+ * changes every frame costs no rasterizing and no texture uploads.
+ */
+class GlyphAtlas {
+    public:
+        GlyphAtlas();
+        ~GlyphAtlas();
+
+        // Rasterize *font*'s glyphs; the font is not needed afterwards
+        bool build(SDL_Renderer *renderer, TTF_Font *font);
+
+        // Free the texture
+        void free();
+
+        // Whether build() succeeded
+        bool loaded() const;
+
+        // Width in pixels of *text* on one line
+        int measure(const std::string &text) const;
+
+        // Distance between baselines
+        int lineSkip() const;
+
+        // Queue *text* with its top left corner at (*x*, *y*); newlines start a new line
+        void add(const std::string &text, int x, int y, SDL_Color color);
+
+        // Draw and empty the queued text; returns the number of draw calls made
+        int flush(SDL_Renderer *renderer);
+
+    private:
+        static const int FIRST_GLYPH = 32;
+        static const int LAST_GLYPH = 126;
+
+        struct Glyph {
+            // where the glyph is in the atlas
+            SDL_Rect source;
+            // horizontal offset from the pen position, and how far the pen moves
+            int offset;
+            int advance;
+        };
+
+        SDL_Texture *mTexture;
+        int mWidth, mHeight;
+        int mLineSkip;
+        std::vector<Glyph> mGlyphs;
+
+        std::vector<SDL_Vertex> mVertices;
+        std::vector<int> mIndices;
+
+        // The glyph for *c*, or nullptr for characters outside the atlas
+        const Glyph *glyph(char c) const;
+};
+
+#endif // GLYPHATLAS_H
@@ -5,30 +5,166 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
-#include "box.hpp"
-#include <deque>
+#include <cstdio>
+#include <cstdlib>
 
 // add sound to the UI
 #include "synthesizer.h"
+#include "voiceslot.h"
 #include "olcNoiseMaker.h"
+#include "clocksync.h"
+#include "calibration.h"
+#include "tilebatch.h"
+#include "tilepool.h"
+#include "fixedstep.h"
+#include "keyboardlayer.h"
+#include "keyatlas.h"
+#include "assetloader.h"
+#include "assetpack.h"
+#include "glyphatlas.h"
+#include "keyinput.h"
+#include "framepacer.h"
+#include "triplebuffer.h"
+#include "playfield.h"
+#include "renderscale.h"
+#include "keylayout.h"
+#include "texturemanager.h"
+#include "eventqueue.h"
 #include <algorithm>
+#include <condition_variable>
+#include <chrono>
+#include <future>
 
 
-synth::instrument *voice = nullptr;
+synth::voiceSlot *voices = nullptr;
 std::vector<synth::note> vecNotes;
+// the click track, while --calibrate is running
+Calibration *calibration = nullptr;
 
 std::mutex muxNotes;
 
 double MakeNoise(double dTime) {
 	std::unique_lock<std::mutex> lm(muxNotes);
+	voices->update(dTime);
 	double dOutput = 0.0;
 	for (const auto& n: vecNotes) {
-		dOutput += voice->sound(n, dTime);
+		dOutput += voices->sound(n, dTime);
 	}
-	return dOutput / vecNotes.size();
+	if (!vecNotes.empty()) {
+		dOutput /= vecNotes.size();
+	}
+	if (calibration != nullptr) {
+		dOutput += calibration->click(dTime);
+	}
+	return dOutput;
+}
+
+// pixels per second the tiles fall at
+const double TILE_SPEED = 300.0;
+// simulation steps per second of audio time
+const double SIM_RATE = 240.0;
+// ms the simulation thread may take to get to a key event, on top of an audio block of lead
+const double NOTE_LEAD_MARGIN_MS = 2.0;
+// the default megabytes of textures kept loaded, held or cached
+const int TEXTURE_BUDGET_MB = 256;
+// ms the simulation sleeps on keys, and the main thread on events, while nothing moves
+const int IDLE_WAIT_MS = 100;
+const int IDLE_REDRAW_MS = 250;
+
+// Everything the main thread draws, as of one pass of the simulation
+struct GameFrame {
+    TilePool tiles;
+    FixedStep simClock;
+    // the simulation's audio clock, so the main thread can tell how far into a step it is
+    ClockSync clock;
+    std::vector<bool> keyPressed;
+    int nNotesPlayed;
+    bool bCalibrating;
+    std::string voiceName;
+    // SDL timestamp of the oldest key event no frame has shown yet, or 0
+    Uint32 nInputStamp;
+    uint64_t nSerial;
+};
+
+// Draw a loading bar filled to *dFraction* across the middle of the window
+void renderProgress(SDL_Renderer *renderer, int nWidth, int nHeight, double dFraction) {
+    SDL_Rect frame{nWidth / 4, nHeight / 2 - 10, nWidth / 2, 20};
+    SDL_Rect bar{frame.x, frame.y, (int)(frame.w * dFraction), frame.h};
+
+    SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+    SDL_RenderClear(renderer);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0xFF);
+    SDL_RenderFillRect(renderer, &bar);
+    SDL_RenderDrawRect(renderer, &frame);
+    SDL_RenderPresent(renderer);
+}
+
+// Build the voice named by *c* (H or B), or return nullptr for any other key
+synth::instrument *makeVoice(char c, bool bNoteCache, int nKeys) {
+    synth::instrument *voice = nullptr;
+    if (c == 'H' || c == 'h') {
+        voice = new synth::instrHarmonica();
+    }
+    else if (c == 'B' || c == 'b') {
+        voice = new synth::instrBell();
+    }
+
+    if (voice != nullptr && bNoteCache) {
+        voice = new synth::instrCached(voice, 44100, nKeys, "notecache_" + voice->name() + ".bin");
+    }
+    return voice;
 }
 
 int main(int argc, char* argv[]) {
+    // --note-cache plays the voice back from pre-rendered per-key tables,
+    // --calibrate measures the output latency before play starts,
+    // --present vsync|limit|late picks how frames are paced and --fps caps them under limit,
+    // --cpu-tiles paints the tiles on the CPU, as is done anyway without a GPU,
+    // --renderer NAME|probe overrides the render driver picked on this machine,
+    // --texture-budget MB caps the textures kept loaded while nothing holds them
+    bool bNoteCache = false;
+    std::string renderDriver;
+    bool bCpuTiles = false;
+    bool bCalibrating = false;
+    PresentMode presentMode = PRESENT_VSYNC;
+    int nFrameRate = 0;
+    int nTextureBudgetMb = TEXTURE_BUDGET_MB;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--note-cache") {
+            bNoteCache = true;
+        }
+        else if (std::string(argv[i]) == "--calibrate") {
+            bCalibrating = true;
+        }
+        else if (std::string(argv[i]) == "--cpu-tiles") {
+            bCpuTiles = true;
+        }
+        else if (std::string(argv[i]) == "--renderer" && i + 1 < argc) {
+            renderDriver = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--present" && i + 1 < argc) {
+            if (!parsePresentMode(argv[++i], presentMode)) {
+                std::cout << "Unknown present mode " << argv[i] << ", using vsync." << std::endl;
+            }
+        }
+        else if (std::string(argv[i]) == "--fps" && i + 1 < argc) {
+            nFrameRate = std::atoi(argv[++i]);
+        }
+        else if (std::string(argv[i]) == "--texture-budget" && i + 1 < argc) {
+            nTextureBudgetMb = std::max(std::atoi(argv[++i]), 0);
+        }
+    }
+
+    // latency measured by an earlier calibration, if any
+    const std::string LATENCY_FILE = "latency.cfg";
+    LatencyProfile latency;
+    latency.load(LATENCY_FILE);
+    if (bCalibrating) {
+        calibration = new Calibration();
+    }
+
+    const int KEYBOARD_SIZE = 12 * 3;
+
     // Get all sound hardware
 	std::vector<std::wstring> devices = olcNoiseMaker<short>::Enumerate();
 
@@ -37,26 +173,21 @@ int main(int argc, char* argv[]) {
 		std::wcout << "Found Output Device: " << d << std::endl;
 	std::wcout << "Using Device: " << devices[0] << '\n' << std::endl;
 
-	// Create sound machine!!
-	olcNoiseMaker<short> sound(devices[0], 44100, 1, 8, 512);
-
-	// Link noise function with sound machine
-	sound.SetUserFunction(MakeNoise);
-
-    // Let the user choose voice
+    // Let the user choose the starting voice, F1 and F2 switch it while playing
+    synth::instrument *voice = nullptr;
     while (voice == nullptr) {
         std::cout << "Choose voice, Harmonica or Bell (H or B): ";
         char c;
         std::cin >> c;
-        if (c == 'H' || c == 'h') {
-            voice = new synth::instrHarmonica();
-            break;
-        }
-        else if (c == 'B' || c == 'b') {
-            voice = new synth::instrBell();
-            break;
-        }
+        voice = makeVoice(c, bNoteCache, KEYBOARD_SIZE);
     }
+    voices = new synth::voiceSlot(voice);
+
+	// Create sound machine!!
+	olcNoiseMaker<short> sound(devices[0], 44100, 1, 8, 512);
+
+	// Link noise function with sound machine
+	sound.SetUserFunction(MakeNoise);
 
     // Create windows
     SDL_Window *window = nullptr;
@@ -64,12 +195,13 @@ int main(int argc, char* argv[]) {
 
     Screen s(1897, 720);
 
-    s.init(window, renderer);
-
-    LTexture keyboardTexture;
-    keyboardTexture.loadFromFile("graphic_files/keyboardClipArt.png", renderer);
+    s.init(window, renderer, FramePacer::vsync(presentMode), renderDriver);
+    // the limit defaults to the display's refresh too, just without waiting on it
+    if (nFrameRate <= 0 || presentMode != PRESENT_LIMIT) {
+        nFrameRate = s.refreshRate(window);
+    }
+    FramePacer pacer(presentMode, nFrameRate);
 
-    const int KEYBOARD_SIZE = 12 * 3;
 
     const std::vector<SDL_Scancode> keyboardScancodes = {
         SDL_SCANCODE_Q, // C1
@@ -149,55 +281,97 @@ int main(int argc, char* argv[]) {
         {SDL_SCANCODE_RSHIFT, "RSHIFT"}
     };
 
-    std::vector<LTexture> keyTextures(KEYBOARD_SIZE);
-    SDL_Color colorKey{0xFF, 0xFF, 0xFF, 0xFF};
-    // loading each key's image into its texture
-    for (size_t i = 0; i < keyTextures.size(); ++i) {
-        std::string path = "graphic_files/individual_keys/" + scancode_to_keyname.at(keyboardScancodes[i]) + "pressed.png";
-        keyTextures[i].loadFromFile(path, renderer, &colorKey);
+    std::vector<std::string> imagePaths = {"graphic_files/keyboardClipArt.png"};
+    for (size_t i = 0; i < keyboardScancodes.size(); ++i) {
+        imagePaths.push_back("graphic_files/individual_keys/" + scancode_to_keyname.at(keyboardScancodes[i]) + "pressed.png");
     }
+    // images loaded by path go through the manager, so each is loaded once however many use it
+    TextureManager textures(renderer, (size_t)nTextureBudgetMb * 1024 * 1024);
+    TextureManager::Handle keyboard;
+    KeyAtlas keyAtlas;
 
-    // setting the width and the x coordinate of the box correspond to the ith note
-    Box boxes[KEYBOARD_SIZE] = {
-        {renderer, 371, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 371 + 32 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2, 0, 29, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2, 0, 29, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2, 0, 24, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 24 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 24 + 2 + 26 + 2, 0, 32, 100, {0, 0, 0xff, 0xff}},
-        /* 7 pixels */
-        {renderer, 740, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 740 + 32 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2, 0, 29, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2, 0, 29, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2, 0, 24, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 24 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 24 + 2 + 26 + 2, 0, 32, 100, {0, 0, 0xff, 0xff}},
-        /* 7 pixels */
-        {renderer, 1109, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 1109 + 32 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2, 0, 29, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2, 0, 29, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2, 0, 24, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 24 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 24 + 2 + 26 + 2, 0, 32, 100, {0, 0, 0xff, 0xff}}
-    };
+    // the packed archive holds every image already decoded and keyed, so they go
+    // to the renderer straight from the mapped file
+    const std::string ASSET_PACK = "graphic_files/assets.pak";
+    AssetPack pack;
+    bool bPacked = pack.open(ASSET_PACK);
+    // a pack missing any image is stale, so decode them all rather than play without some keys
+    for (size_t i = 0; bPacked && i < imagePaths.size(); ++i) {
+        if (pack.find(imagePaths[i]) == nullptr) {
+            std::cout << ASSET_PACK << " has no " << imagePaths[i] << ", decoding the images instead." << std::endl;
+            bPacked = false;
+        }
+    }
+    if (bPacked && (keyboard = textures.acquire(pack, imagePaths[0]))) {
+        std::vector<SDL_Surface*> overlays;
+        for (size_t i = 1; i < imagePaths.size(); ++i) {
+            const PackImage *image = pack.find(imagePaths[i]);
+            // these surfaces only point at the mapping, nothing is copied
+            overlays.push_back(SDL_CreateRGBSurfaceWithFormatFrom(
+                (void*)image->pixels, image->width, image->height, 32, image->pitch, SDL_PIXELFORMAT_RGBA32));
+        }
+        keyAtlas.build(renderer, overlays);
+        for (auto surface: overlays) {
+            SDL_FreeSurface(surface);
+        }
+    } else {
+        // decode the keyboard and every key's image in parallel, showing progress meanwhile
+        AssetLoader loader(imagePaths);
+        while (!loader.done()) {
+            SDL_PumpEvents();
+            renderProgress(renderer, s.SCREEN_WIDTH, s.SCREEN_HEIGHT, (double)loader.decoded() / loader.size());
+            // without vsync the present returns at once, so leave the cores to the workers
+            SDL_Delay(1);
+        }
+
+        // then upload them: the keyboard as is, the keys packed into one texture
+        std::vector<SDL_Surface*> surfaces = loader.take();
+        SDL_Color colorKey{0xFF, 0xFF, 0xFF, 0xFF};
+        keyboard = textures.acquire(imagePaths[0], surfaces[0]);
+        keyAtlas.build(renderer, std::vector<SDL_Surface*>(surfaces.begin() + 1, surfaces.end()), &colorKey);
+        for (auto surface: surfaces) {
+            SDL_FreeSurface(surface);
+        }
+    }
+    pack.close();
+    // without the keyboard image the game still plays, over an empty keyboard
+    const LTexture noTexture;
+    const LTexture &keyboardTexture = keyboard ? *keyboard.get() : noTexture;
+
+    // the HUD's glyphs, rasterized once; without the font the game runs without a HUD
+    const std::string FONT_FILE = "graphic_files/font.ttf";
+    GlyphAtlas hudText;
+    TTF_Font *font = TTF_OpenFont(FONT_FILE.c_str(), 20);
+    if (font == nullptr) {
+        std::cout << "Failed to load font " << FONT_FILE << ", playing without the HUD. SDL_ttf Error: " << TTF_GetError() << std::endl;
+    }
+    else {
+        hudText.build(renderer, font);
+        TTF_CloseFont(font);
+    }
+    int nNotesPlayed = 0;
+
+    // the lanes the notes' tiles fall in, laid out once from an octave's description;
+    // a keyboard image with other lanes ships its own description next to it, for the
+    // same number of keys, since the key bindings and sounds are fixed
+    const std::string LAYOUT_FILE = "graphic_files/layout.cfg";
+    KeyboardSpec keyboardSpec;
+    if (keyboardSpec.load(LAYOUT_FILE) && keyboardSpec.nKeys != KEYBOARD_SIZE) {
+        std::cout << LAYOUT_FILE << " does not describe " << KEYBOARD_SIZE << " keys, using the built-in layout." << std::endl;
+        keyboardSpec = KeyboardSpec();
+    }
+    KeyLayout keyLayout;
+    keyLayout.build(keyboardSpec, s.SCREEN_WIDTH);
+    const SDL_Rect *lanes = keyLayout.lanes();
+
+    // tile colors, indexed by laneColors, which follow each lane's note from C to B
+    enum { RED, GREEN, BLUE };
+    const std::vector<SDL_Color> palette = {{0xff, 0, 0, 0xff}, {0, 0xff, 0, 0xff}, {0, 0, 0xff, 0xff}};
+    const int octaveColors[12] = {RED, GREEN, BLUE, GREEN, RED, RED, GREEN, BLUE, GREEN, BLUE, GREEN, BLUE};
+    std::vector<int> laneColors(KEYBOARD_SIZE);
+    for (int i = 0; i < KEYBOARD_SIZE; ++i) {
+        laneColors[i] = octaveColors[(keyboardSpec.nFirst + i) % 12];
+    }
 
     // viewport for rendering the keyboard
     SDL_Rect bottomViewport{0, s.SCREEN_HEIGHT - keyboardTexture.getHeight(), s.SCREEN_WIDTH, keyboardTexture.getHeight()};
@@ -205,78 +379,392 @@ int main(int argc, char* argv[]) {
     // viewport for rendering the falling boxes
     SDL_Rect topViewport{0, 0, s.SCREEN_WIDTH, s.SCREEN_HEIGHT - keyboardTexture.getHeight()};
 
-    bool quit = false;
+    // the keyboard and its pressed keys, repainted only where keys change
+    KeyboardLayer keyboardLayer;
+    bool bKeyboardLayer = keyboardLayer.init(renderer, keyboardTexture, keyAtlas, KEYBOARD_SIZE);
+
+    // SDL's software renderer fills rects one by one, so paint the tiles ourselves
+    SDL_RendererInfo rendererInfo;
+    if (SDL_GetRendererInfo(renderer, &rendererInfo) == 0 && (rendererInfo.flags & SDL_RENDERER_SOFTWARE)) {
+        bCpuTiles = true;
+    }
+    Playfield playfield;
+    if (!playfield.init(renderer, topViewport.w, topViewport.h, SDL_Color{0xFF, 0xFF, 0xFF, 0xFF}, bCpuTiles)) {
+        bCpuTiles = false;
+    }
+    // when frames run over, the playfield is drawn at a lower resolution and scaled up; only
+    // the CPU painter's cost shows in the frame's work time, a GPU's is spent after present
+    RenderScale renderScale(1.0 / nFrameRate);
+
+    TilePool tiles(TILE_SPEED, lanes[0].h);
+    TileBatch tileBatch(palette);
+    // the open tile of each held key, and the ticks its press was stamped with and the onset it got
+    std::vector<int> heldTiles(KEYBOARD_SIZE, -1);
+    std::vector<Uint32> pressTicks(KEYBOARD_SIZE, 0);
+    std::vector<double> pressOnsets(KEYBOARD_SIZE, 0.0);
+
+    // keys are played by events as they arrive, each at the audio time it was stamped with
+    KeyInput input(keyboardScancodes);
+
+    // tiles move with the audio clock rather than with frames, so they stay in step with the sound
+    ClockSync audioClock(sound.GetSampleRate());
+    FixedStep simClock(1.0 / SIM_RATE);
+    // the audio thread renders up to a block past the clock, so an onset stamped with the
+    // event's own time would lose the start of its attack to the event's age; every note and
+    // tile starts a fixed lead after its event instead, so all onsets have the same delay;
+    // the lead is a block plus the time the simulation takes to wake for the event
+    const double dBlockTime = (double)sound.GetBlockSamples() / sound.GetSampleRate();
+    const double dNoteLead = dBlockTime + NOTE_LEAD_MARGIN_MS / 1000.0;
+
+    // the simulation runs on its own thread and hands each frame it changes to this one,
+    // which owns the renderer and the window's events, so a slow present never holds up
+    // notes or tile timing
+    GameFrame initialFrame{tiles, simClock, audioClock, std::vector<bool>(KEYBOARD_SIZE, false), 0, bCalibrating, voices->get()->name(), 0, 0};
+    TripleBuffer<GameFrame> frames(initialFrame);
+    std::atomic<bool> quit(false);
+    // the serial of the frame this thread last took
+    std::atomic<uint64_t> nShownSerial(0);
+    // set while this thread sleeps on events, so the simulation wakes it with a new frame
+    std::atomic<bool> renderIdle(false);
+    const Uint32 FRAME_EVENT = SDL_RegisterEvents(1);
+
+    // key events, passed on to the simulation as they are pumped, which wakes it
+    EventQueue<SDL_KeyboardEvent, 256> keyEvents;
+    std::mutex muxInput;
+    std::condition_variable inputReady;
+    bool bInputReady = false;
+
+    std::thread simThread([&]() {
+        uint64_t nSerial = 0;
+        // the oldest key event no frame has shown yet, and the first frame that carries it
+        Uint32 nPendingInput = 0;
+        uint64_t nPendingSerial = 0;
+        // tiles are on screen, notes are sounding or calibration is running
+        bool bAnimating = true;
+        // the voice F1 or F2 asked for, built on a worker since a cached one renders every
+        // note first; a voice asked for meanwhile is built after it
+        std::future<synth::instrument*> nextVoice;
+        char queuedVoice = 0;
+        while (!quit) {
+            // sleep until the next step is due, or with nothing moving until the next key
+            {
+                std::unique_lock<std::mutex> li(muxInput);
+                if (bAnimating || nextVoice.valid()) {
+                    inputReady.wait_for(li, std::chrono::microseconds((int)(1e6 / SIM_RATE)), [&]() {
+                        return bInputReady || quit.load();
+                    });
+                }
+                else {
+                    inputReady.wait_for(li, std::chrono::milliseconds(IDLE_WAIT_MS), [&]() {
+                        return bInputReady || quit.load();
+                    });
+                }
+                bInputReady = false;
+            }
+
+            // one smoothed audio time for everything in this pass
+            uint64_t nSamples, nCounter;
+            sound.GetClock(nSamples, nCounter);
+            audioClock.update(nSamples, nCounter);
+            double dTimeNow = audioClock.locked() ? audioClock.now() : sound.GetTime();
+
+            // the audio time an event happened at, not the time the loop got to it
+            auto eventTime = [&](Uint32 nTimestamp) {
+                return audioClock.locked() ? audioClock.timeAtTicks(nTimestamp) : dTimeNow;
+            };
+
+            // an event older than the lead still starts at once rather than part-way through
+            auto onsetTime = [&](Uint32 nTimestamp) {
+                return std::max(eventTime(nTimestamp) + dNoteLead, dTimeNow + dBlockTime);
+            };
+
+            bool bChanged = false;
+            SDL_KeyboardEvent key;
+            while (keyEvents.pop(key)) {
+                int i = input.handle(key);
+                if (i >= 0) {
+                    bChanged = true;
+                    if (nPendingInput == 0) {
+                        nPendingInput = key.timestamp;
+                        nPendingSerial = nSerial + 1;
+                    }
+                    double dOnsetTime = onsetTime(key.timestamp);
+                    std::unique_lock<std::mutex> lm(muxNotes);
+                    auto noteFound = std::find_if(vecNotes.begin(), vecNotes.end(), [&i](const synth::note& n) {
+                        return n.id == i;
+                    });
+
+                    if (input.pressed(i)) {
+                        // a press opens a tile, which grows for as long as the key is held
+                        heldTiles[i] = tiles.open(i, laneColors[i], dOnsetTime);
+                        pressTicks[i] = key.timestamp;
+                        pressOnsets[i] = dOnsetTime;
+
+                        // start the note, or restart it if it is still releasing
+                        if (noteFound != vecNotes.end()) {
+                            vecNotes.erase(noteFound);
+                        }
+                        vecNotes.push_back(synth::note(i, dOnsetTime));
+                        ++nNotesPlayed;
+                    }
+                    else {
+                        // a press and release handled late both clamp to the same onset, so the
+                        // release keeps its distance from the press's onset and a tap still sounds;
+                        // the stamps give that distance even before the audio clock locks
+                        dOnsetTime = std::max(dOnsetTime, pressOnsets[i] + (Uint32)(key.timestamp - pressTicks[i]) / 1000.0);
+
+                        // close the key's tile so it falls away
+                        tiles.close(heldTiles[i], dOnsetTime);
+                        heldTiles[i] = -1;
+
+                        // put the note in release mode
+                        if (noteFound != vecNotes.end()) {
+                            noteFound->dTimeOff = dOnsetTime;
+                        }
+                    }
+                }
+                // swap the voice without stopping the sound
+                else if (key.type == SDL_KEYDOWN && !key.repeat) {
+                    if (key.keysym.scancode == SDL_SCANCODE_F1 || key.keysym.scancode == SDL_SCANCODE_F2) {
+                        queuedVoice = key.keysym.scancode == SDL_SCANCODE_F1 ? 'H' : 'B';
+                    }
+                    else if (key.keysym.scancode == SDL_SCANCODE_SPACE && bCalibrating) {
+                        calibration->tap(eventTime(key.timestamp));
+                    }
+                }
+            }
+
+            // hand the audio thread the new voice once it is built, and start the next one asked for
+            if (nextVoice.valid() && nextVoice.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                voices->set(nextVoice.get());
+                bChanged = true;
+            }
+            if (!nextVoice.valid() && queuedVoice != 0) {
+                nextVoice = std::async(std::launch::async, makeVoice, queuedVoice, bNoteCache, KEYBOARD_SIZE);
+                queuedVoice = 0;
+            }
+
+            // free the voices the audio thread has finished fading out
+            voices->collect();
+
+            // drop the notes whose release has finished
+            bool bSounding;
+            {
+                std::unique_lock<std::mutex> lm(muxNotes);
+                double dReleaseTime = voices->get()->env.dReleaseTime;
+                vecNotes.erase(std::remove_if(vecNotes.begin(), vecNotes.end(), [&](const synth::note& n) {
+                    return n.dTimeOff >= n.dTimeOn && dTimeNow - n.dTimeOff > dReleaseTime;
+                }), vecNotes.end());
+                bSounding = !vecNotes.empty();
+            }
+
+            if (bCalibrating) {
+                if (!calibration->started() && audioClock.locked()) {
+                    std::cout << "Calibrating: tap SPACE on every click you hear, then on every square you see." << std::endl;
+                    calibration->start(dTimeNow + 1.0);
+                }
+                else if (calibration->done(dTimeNow)) {
+                    bCalibrating = false;
+                    bChanged = true;
+                    if (calibration->result(latency)) {
+                        latency.save(LATENCY_FILE);
+                        std::cout << "Audio latency " << latency.dAudioOffset * 1000.0 << " ms, visual latency "
+                                  << latency.dVisualOffset * 1000.0 << " ms, saved to " << LATENCY_FILE << std::endl;
+                    }
+                    else {
+                        std::cout << "Too few taps to calibrate, keeping the previous latency." << std::endl;
+                    }
+                }
+            }
+
+            // simulate in fixed steps of audio time, so nothing depends on the frame rate;
+            // place the tiles at the time being heard when the frame reaches the screen,
+            // and retire the ones that have fallen out of view
+            int nSteps = simClock.advance(dTimeNow);
+            for (int k = 0; k < nSteps; ++k) {
+                tiles.update(latency.displayTime(simClock.stepTime(k)), topViewport.h);
+            }
+
+            // a frame has shown the pending input once the main thread took one at least as new
+            if (nPendingInput != 0 && nShownSerial.load(std::memory_order_acquire) >= nPendingSerial) {
+                nPendingInput = 0;
+            }
+
+            // once the last tile has gone and the last note has faded, the steps change nothing on screen
+            bool bWasAnimating = bAnimating;
+            bAnimating = tiles.size() > 0 || bSounding || bCalibrating;
+
+            // hand over a new frame whenever something drawn changed,
+            // including the one frame that clears the last tile away
+            if (bChanged || (nSteps > 0 && (bAnimating || bWasAnimating))) {
+                GameFrame &frame = frames.back();
+                tiles.copyTo(frame.tiles);
+                frame.simClock = simClock;
+                frame.clock = audioClock;
+                for (int i = 0; i < KEYBOARD_SIZE; ++i) {
+                    frame.keyPressed[i] = input.pressed(i);
+                }
+                frame.nNotesPlayed = nNotesPlayed;
+                frame.bCalibrating = bCalibrating;
+                frame.voiceName = voices->get()->name();
+                frame.nInputStamp = nPendingInput;
+                frame.nSerial = ++nSerial;
+                frames.publish();
+
+                // pairs with the fence before the main thread checks for a frame and sleeps
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (renderIdle.exchange(false)) {
+                    SDL_Event wake{};
+                    wake.type = FRAME_EVENT;
+                    SDL_PushEvent(&wake);
+                }
+            }
+        }
+
+        // a voice still being built is never played
+        if (nextVoice.valid()) {
+            delete nextVoice.get();
+        }
+    });
+
+    // wake the simulation for the keys just pumped, or for the quit
+    auto wakeSim = [&]() {
+        std::unique_lock<std::mutex> li(muxInput);
+        bInputReady = true;
+        inputReady.notify_one();
+    };
+
+    // the input timestamp last counted by the pacer
+    Uint32 nCountedInput = 0;
+    // the last frame drawn had nothing moving on it
+    bool bIdle = false;
     SDL_Event e;
-    std::deque<Box> q;
-    
-    // main loop
     while (!quit) {
-        // handle quit event
-        while (SDL_PollEvent(&e) != 0) {
+        // while idle, sleep until an input or the simulation's next frame, and present nothing until then
+        bool bRedraw = false;
+        bool bEvent;
+        if (bIdle) {
+            renderIdle = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bRedraw = frames.update();
+            bEvent = (bRedraw ? SDL_PollEvent(&e) : SDL_WaitEventTimeout(&e, IDLE_REDRAW_MS)) != 0;
+            renderIdle = false;
+        }
+        else {
+            bEvent = SDL_PollEvent(&e) != 0;
+        }
+
+        bool bKeys = false;
+        for (; bEvent; bEvent = SDL_PollEvent(&e) != 0) {
             if (e.type == SDL_QUIT) {
                 quit = true;
             }
-            for (auto &box: q) {
-                box.move(s.SCREEN_HEIGHT);
+            // render targets lose their contents when the device is reset
+            else if (e.type == SDL_RENDER_TARGETS_RESET) {
+                if (bKeyboardLayer) {
+                    keyboardLayer.invalidate();
+                }
+                bRedraw = true;
+            }
+            // redraw a window that was uncovered or restored while idle
+            else if (e.type == SDL_WINDOWEVENT || e.type == FRAME_EVENT) {
+                bRedraw = true;
+            }
+            else if (e.type == SDL_KEYDOWN || e.type == SDL_KEYUP) {
+                // the simulation drains the queue every step, so a full one empties soon
+                while (!keyEvents.push(e.key)) {
+                    wakeSim();
+                    SDL_Delay(1);
+                }
+                bKeys = true;
             }
         }
+        if (bKeys || quit) {
+            wakeSim();
+        }
+        if (quit || (bIdle && !bRedraw)) {
+            continue;
+        }
+
+        // under late latch this sleeps until the frame taken below is as fresh as it can be
+        pacer.wait();
+        frames.update();
+        const GameFrame &frame = frames.front();
+        nShownSerial.store(frame.nSerial, std::memory_order_release);
+        if (frame.nInputStamp != 0 && frame.nInputStamp != nCountedInput) {
+            pacer.input(frame.nInputStamp);
+            nCountedInput = frame.nInputStamp;
+        }
+        double dTimeNow = frame.clock.locked() ? frame.clock.now() : sound.GetTime();
 
-        // dequeue disappeared boxes
-        while (!q.empty() && q.front().getH() == 0) {
-            q.pop_front();
+        // repaint the keys that changed, before the frame's viewports are set
+        if (bKeyboardLayer) {
+            for (int i = 0; i < KEYBOARD_SIZE; ++i) {
+                keyboardLayer.setPressed(i, frame.keyPressed[i]);
+            }
+            keyboardLayer.refresh(renderer);
         }
-        
+
         // clear the screen
         SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
         SDL_RenderClear(renderer);
-        
+
         // render the keyboard
         SDL_RenderSetViewport(renderer, &bottomViewport);
-        keyboardTexture.render(renderer, 0, 0);
-
-        const Uint8 *currentKeyState = SDL_GetKeyboardState(nullptr);
-        double dTimeNow = sound.GetTime();
-        for (size_t i = 0; i < keyboardScancodes.size(); ++i) {
-            auto noteFound = std::find_if(vecNotes.begin(), vecNotes.end(), [&i](const synth::note& n) {
-                return n.id == i;
-            });
-            
-            // if the key is pressed
-            if (currentKeyState[keyboardScancodes[i]]) {
-                keyTextures[i].render(renderer, 0, 0);
-                q.push_back(boxes[i]);
-
-                // if the note has not been active yet, start playing it
-                if (noteFound == vecNotes.end()) {
-                    synth::note newNote(i, dTimeNow);
-                    vecNotes.push_back(newNote);
+        if (bKeyboardLayer) {
+            keyboardLayer.render(renderer);
+        }
+        // without render targets, draw the keyboard and every pressed key each frame
+        else {
+            keyboardTexture.render(renderer, 0, 0);
+            for (int i = 0; i < KEYBOARD_SIZE; ++i) {
+                if (frame.keyPressed[i]) {
+                    keyAtlas.add(i);
                 }
-                // if the note is still being active, do nothing as the user simply keeps holding the key
             }
-            else {
-				// if the key is not pressed anymore and the note is still being active
-				if (noteFound != vecNotes.end()) {
-					// either put it in release mode
-					if (noteFound->dTimeOff < noteFound->dTimeOn) {
-						noteFound->dTimeOff = dTimeNow;
-					}
-					// or erase it if its release mode has finished
-					else if (dTimeNow - noteFound->dTimeOff > voice->env.dReleaseTime) {
-						vecNotes.erase(noteFound);
-					}					
-				}
-			}
+            keyAtlas.flush(renderer);
         }
-        
+
+        // draw the tiles between the last two steps
         SDL_RenderSetViewport(renderer, &topViewport);
-        for (auto &box: q) {
-            box.move(s.SCREEN_HEIGHT);
-            box.render();
+        frame.tiles.draw(tileBatch, lanes, frame.simClock.alpha(dTimeNow));
+        playfield.render(renderer, tileBatch, renderScale.scale());
+
+        // the calibration's visual beat
+        if (frame.bCalibrating && calibration->flash(dTimeNow)) {
+            SDL_Rect marker{topViewport.w / 2 - 50, topViewport.h / 2 - 50, 100, 100};
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0xFF);
+            SDL_RenderFillRect(renderer, &marker);
+        }
+
+        // the HUD, laid out from the cached glyphs and drawn in one call
+        if (hudText.loaded()) {
+            char latencyText[96];
+            snprintf(latencyText, sizeof(latencyText), "\nInput to present %.1f ms (p99 %.1f, %s)\nPlayfield scale %d%%",
+                     pacer.inputLatency(), pacer.inputLatencyP99(), pacer.name(), (int)(renderScale.scale() * 100.0 + 0.5));
+            std::string hud = "Notes " + std::to_string(frame.nNotesPlayed) + "\nVoice " + frame.voiceName + latencyText;
+            if (frame.bCalibrating) {
+                hud += "\nTap SPACE on every click you hear, then on every square you see";
+            }
+            hudText.add(hud, 10, 10, SDL_Color{0, 0, 0, 0xFF});
+            hudText.flush(renderer);
         }
 
-        SDL_RenderPresent(renderer);
+        pacer.present(renderer);
+        if (bCpuTiles) {
+            renderScale.update(pacer.workTime());
+        }
+        bIdle = frame.tiles.size() == 0 && !frame.bCalibrating;
     }
 
+    simThread.join();
+    sound.Stop();
+    delete voices;
+    delete calibration;
+
+    // the textures go before the renderer they belong to
+    keyboard.reset();
+    textures.setBudget(0);
     s.close(window, renderer);
     return 0;
 }
\ No newline at end of file
@@ -6,8 +6,13 @@
 #include <string>
 #include <unordered_map>
 #include "box.hpp"
+#include "keylayout.h"
+#include "texturemanager.h"
 #include <deque>
 
+// bytes of textures kept loaded, held or cached
+const size_t TEXTURE_BUDGET_BYTES = 64 * 1024 * 1024;
+
 int main(int argc, char* argv[]) {
     // Create windows
     SDL_Window *window = nullptr;
@@ -17,8 +22,9 @@ int main(int argc, char* argv[]) {
 
     s.init(window, renderer);
 
-    LTexture keyboardTexture;
-    keyboardTexture.loadFromFile("graphic_files/keyboardClipArt.png", renderer);
+    TextureManager textures(renderer, TEXTURE_BUDGET_BYTES);
+    TextureManager::Handle keyboardTexture = textures.acquire("graphic_files/keyboardClipArt.png");
+    int nKeyboardHeight = keyboardTexture ? keyboardTexture->getHeight() : 0;
 
     const int KEYBOARD_SIZE = 12 * 3;
 
@@ -100,61 +106,30 @@ int main(int argc, char* argv[]) {
         {SDL_SCANCODE_RSHIFT, "RSHIFT"}
     };
 
-    std::vector<LTexture> keyTextures(KEYBOARD_SIZE);
+    std::vector<TextureManager::Handle> keyTextures(KEYBOARD_SIZE);
     SDL_Color colorKey{0xFF, 0xFF, 0xFF, 0xFF};
     // loading each key's image into its texture
     for (size_t i = 0; i < keyTextures.size(); ++i) {
         std::string path = "graphic_files/individual_keys/" + scancode_to_keyname.at(keyboardScancodes[i]) + "pressed.png";
-        keyTextures[i].loadFromFile(path, renderer, &colorKey);
+        keyTextures[i] = textures.acquire(path, &colorKey);
     }
 
     // setting the width and the x coordinate of the box correspond to the ith note
-    Box boxes[KEYBOARD_SIZE] = {
-        {renderer, 371, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 371 + 32 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2, 0, 29, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2, 0, 29, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2, 0, 24, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 24 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 371 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 24 + 2 + 26 + 2, 0, 32, 100, {0, 0, 0xff, 0xff}},
-        /* 7 pixels */
-        {renderer, 740, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 740 + 32 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2, 0, 29, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2, 0, 29, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2, 0, 24, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 24 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 740 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 24 + 2 + 26 + 2, 0, 32, 100, {0, 0, 0xff, 0xff}},
-        /* 7 pixels */
-        {renderer, 1109, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 1109 + 32 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2, 0, 29, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2, 0, 32, 100, {0xff, 0, 0, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2, 0, 29, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2, 0, 24, 100, {0, 0, 0xff, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 24 + 2, 0, 26, 100, {0, 0xff, 0, 0xff}},
-        {renderer, 1109 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 32 + 2 + 32 + 2 + 26 + 2 + 29 + 2 + 26 + 2 + 24 + 2 + 26 + 2, 0, 32, 100, {0, 0, 0xff, 0xff}}
-    };
+    const SDL_Color red{0xff, 0, 0, 0xff}, green{0, 0xff, 0, 0xff}, blue{0, 0, 0xff, 0xff};
+    const SDL_Color octaveColors[12] = {red, green, blue, green, red, red, green, blue, green, blue, green, blue};
+    KeyLayout keyLayout;
+    keyLayout.build(KeyboardSpec(), s.SCREEN_WIDTH);
+    std::vector<Box> boxes;
+    for (int i = 0; i < KEYBOARD_SIZE; ++i) {
+        const SDL_Rect &lane = keyLayout.lanes()[i];
+        boxes.push_back(Box{renderer, lane.x, lane.y, lane.w, lane.h, octaveColors[i % 12]});
+    }
 
     // viewport for rendering the keyboard
-    SDL_Rect bottomViewport{0, s.SCREEN_HEIGHT - keyboardTexture.getHeight(), s.SCREEN_WIDTH, keyboardTexture.getHeight()};
+    SDL_Rect bottomViewport{0, s.SCREEN_HEIGHT - nKeyboardHeight, s.SCREEN_WIDTH, nKeyboardHeight};
 
     // viewport for rendering the falling boxes
-    SDL_Rect topViewport{0, 0, s.SCREEN_WIDTH, s.SCREEN_HEIGHT - keyboardTexture.getHeight()};
+    SDL_Rect topViewport{0, 0, s.SCREEN_WIDTH, s.SCREEN_HEIGHT - nKeyboardHeight};
 
     bool quit = false;
     SDL_Event e;
@@ -183,13 +158,17 @@ int main(int argc, char* argv[]) {
         
         // render the keyboard
         SDL_RenderSetViewport(renderer, &bottomViewport);
-        keyboardTexture.render(renderer, 0, 0);
+        if (keyboardTexture) {
+            keyboardTexture->render(renderer, 0, 0);
+        }
 
         const Uint8 *currentKeyState = SDL_GetKeyboardState(nullptr);       
         for (size_t i = 0; i < keyboardScancodes.size(); ++i) {            
             // if the key is pressed
             if (currentKeyState[keyboardScancodes[i]]) {
-                keyTextures[i].render(renderer, 0, 0);
+                if (keyTextures[i]) {
+                    keyTextures[i]->render(renderer, 0, 0);
+                }
                 q.push_back(boxes[i]);                
 			}
         }
@@ -203,6 +182,10 @@ int main(int argc, char* argv[]) {
         SDL_RenderPresent(renderer);
     }
 
+    // the textures go before the renderer they belong to
+    keyboardTexture.reset();
+    keyTextures.clear();
+    textures.setBudget(0);
     s.close(window, renderer);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "keyatlas.h"
+#include <algorithm>
+#include <cstdio>
+
+// transparent gap around every packed overlay, so filtering never samples a neighbour
+const int nAtlasPadding = 1;
+const int nMinAtlasWidth = 1024;
+
+KeyAtlas::KeyAtlas() {
+    mTexture = nullptr;
+    mWidth = mHeight = 0;
+}
+
+KeyAtlas::~KeyAtlas() {
+    free();
+}
+
+void KeyAtlas::free() {
+    if (mTexture != nullptr) {
+        SDL_DestroyTexture(mTexture);
+        mTexture = nullptr;
+        mWidth = mHeight = 0;
+    }
+}
+
+bool KeyAtlas::build(SDL_Renderer *renderer, const std::vector<SDL_Surface*> &overlays, const SDL_Color *colorKey /*= nullptr*/) {
+    free();
+    mSource.assign(overlays.size(), SDL_Rect{0, 0, 0, 0});
+    mBounds.assign(overlays.size(), SDL_Rect{0, 0, 0, 0});
+
+    // turn the color key into alpha and find the rect each overlay covers
+    std::vector<SDL_Surface*> converted(overlays.size(), nullptr);
+    int nMaxWidth = 0;
+    for (size_t k = 0; k < overlays.size(); ++k) {
+        if (overlays[k] == nullptr) {
+            continue;
+        }
+        SDL_Surface *surface = SDL_ConvertSurfaceFormat(overlays[k], SDL_PIXELFORMAT_RGBA32, 0);
+        if (surface == nullptr) {
+            printf("Failed to convert key overlay %d. SDL Error: %s\n", (int)k, SDL_GetError());
+            continue;
+        }
+        converted[k] = surface;
+
+        int left = surface->w, top = surface->h, right = -1, bottom = -1;
+        for (int y = 0; y < surface->h; ++y) {
+            Uint8 *pixel = (Uint8*)surface->pixels + y * surface->pitch;
+            for (int x = 0; x < surface->w; ++x, pixel += 4) {
+                if (colorKey != nullptr && pixel[0] == colorKey->r && pixel[1] == colorKey->g && pixel[2] == colorKey->b) {
+                    pixel[3] = 0;
+                }
+                if (pixel[3] != 0) {
+                    left = std::min(left, x);
+                    right = std::max(right, x);
+                    top = std::min(top, y);
+                    bottom = std::max(bottom, y);
+                }
+            }
+        }
+        if (right >= 0) {
+            mBounds[k] = {left, top, right - left + 1, bottom - top + 1};
+            nMaxWidth = std::max(nMaxWidth, mBounds[k].w);
+        }
+    }
+
+    // shelf packing, tallest first
+    std::vector<int> order(overlays.size());
+    for (size_t k = 0; k < order.size(); ++k) {
+        order[k] = k;
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return mBounds[a].h > mBounds[b].h;
+    });
+    int nWidth = std::max(nMinAtlasWidth, nMaxWidth + 2 * nAtlasPadding);
+    int x = 0, y = 0, nShelfHeight = 0;
+    for (int k: order) {
+        const SDL_Rect &b = mBounds[k];
+        if (b.w == 0) {
+            continue;
+        }
+        if (x + b.w + 2 * nAtlasPadding > nWidth) {
+            x = 0;
+            y += nShelfHeight;
+            nShelfHeight = 0;
+        }
+        mSource[k] = {x + nAtlasPadding, y + nAtlasPadding, b.w, b.h};
+        x += b.w + 2 * nAtlasPadding;
+        nShelfHeight = std::max(nShelfHeight, b.h + 2 * nAtlasPadding);
+    }
+    int nHeight = std::max(y + nShelfHeight, 1);
+
+    bool success = false;
+    SDL_Surface *atlas = SDL_CreateRGBSurfaceWithFormat(0, nWidth, nHeight, 32, SDL_PIXELFORMAT_RGBA32);
+    if (atlas == nullptr) {
+        printf("Failed to create key atlas surface. SDL Error: %s\n", SDL_GetError());
+    }
+    else {
+        SDL_FillRect(atlas, nullptr, 0);
+        for (size_t k = 0; k < converted.size(); ++k) {
+            if (converted[k] != nullptr && mBounds[k].w > 0) {
+                // copy the pixels, alpha included, rather than blending them in
+                SDL_SetSurfaceBlendMode(converted[k], SDL_BLENDMODE_NONE);
+                SDL_Rect dst = mSource[k];
+                SDL_BlitSurface(converted[k], &mBounds[k], atlas, &dst);
+            }
+        }
+
+        mTexture = SDL_CreateTextureFromSurface(renderer, atlas);
+        if (mTexture == nullptr) {
+            printf("Failed to create key atlas texture. SDL Error: %s\n", SDL_GetError());
+        }
+        else {
+            SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_BLEND);
+            mWidth = nWidth;
+            mHeight = nHeight;
+            success = true;
+        }
+        SDL_FreeSurface(atlas);
+    }
+
+    for (auto surface: converted) {
+        SDL_FreeSurface(surface);
+    }
+    return success;
+}
+
+const SDL_Rect &KeyAtlas::bounds(int key) const {
+    return mBounds[key];
+}
+
+void KeyAtlas::add(int key, const SDL_Rect *clip /*= nullptr*/) {
+    SDL_Rect dst = mBounds[key];
+    if (clip != nullptr && !SDL_IntersectRect(&mBounds[key], clip, &dst)) {
+        return;
+    }
+    if (dst.w <= 0 || dst.h <= 0) {
+        return;
+    }
+
+    // the clipped part of the source, in texture coordinates
+    float u0 = (float)(mSource[key].x + dst.x - mBounds[key].x) / mWidth;
+    float v0 = (float)(mSource[key].y + dst.y - mBounds[key].y) / mHeight;
+    float u1 = u0 + (float)dst.w / mWidth;
+    float v1 = v0 + (float)dst.h / mHeight;
+    float x0 = (float)dst.x, y0 = (float)dst.y, x1 = (float)(dst.x + dst.w), y1 = (float)(dst.y + dst.h);
+
+    int base = mVertices.size();
+    SDL_Color white{0xFF, 0xFF, 0xFF, 0xFF};
+    mVertices.push_back({{x0, y0}, white, {u0, v0}});
+    mVertices.push_back({{x1, y0}, white, {u1, v0}});
+    mVertices.push_back({{x1, y1}, white, {u1, v1}});
+    mVertices.push_back({{x0, y1}, white, {u0, v1}});
+    int quad[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+    mIndices.insert(mIndices.end(), quad, quad + 6);
+}
+
+int KeyAtlas::flush(SDL_Renderer *renderer) {
+    if (mIndices.empty()) {
+        return 0;
+    }
+    SDL_RenderGeometry(renderer, mTexture, mVertices.data(), mVertices.size(), mIndices.data(), mIndices.size());
+    mVertices.clear();
+    mIndices.clear();
+    return 1;
+}
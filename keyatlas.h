@@ -0,0 +1,48 @@
+#ifndef KEYATLAS_H
+#define KEYATLAS_H
+
+#include <SDL.h>
+#include <vector>
+
+/**
+ * The pressed-key overlays, cropped to the pixels each one actually covers and
+ * packed into a single texture.
+ *
+ * Every overlay image is the size of the whole keyboard with all but its key
+ * color-keyed out; the atlas keeps only each key's bounding rect, and the
+ * queued keys are drawn together with one SDL_RenderGeometry call.
+ */
+class KeyAtlas {
+    public:
+        KeyAtlas();
+        ~KeyAtlas();
+
+        // Pack *overlays*, where pixels matching *colorKey* are transparent. The
+        // surfaces are only read; the caller still owns them.
+        bool build(SDL_Renderer *renderer, const std::vector<SDL_Surface*> &overlays, const SDL_Color *colorKey = nullptr);
+
+        // Free the texture
+        void free();
+
+        // Where key *key*'s overlay lands on the keyboard; empty if it covers nothing
+        const SDL_Rect &bounds(int key) const;
+
+        // Queue key *key*'s overlay, limited to *clip* (in keyboard coordinates) when given
+        void add(int key, const SDL_Rect *clip = nullptr);
+
+        // Draw and empty the queued overlays; returns the number of draw calls made
+        int flush(SDL_Renderer *renderer);
+
+    private:
+        SDL_Texture *mTexture;
+        int mWidth, mHeight;
+
+        // per key: its rect in the atlas and on the keyboard
+        std::vector<SDL_Rect> mSource;
+        std::vector<SDL_Rect> mBounds;
+
+        std::vector<SDL_Vertex> mVertices;
+        std::vector<int> mIndices;
+};
+
+#endif // KEYATLAS_H
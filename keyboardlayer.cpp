@@ -0,0 +1,78 @@
+#include "keyboardlayer.h"
+
+KeyboardLayer::KeyboardLayer() {
+    mKeyboard = nullptr;
+    mKeys = nullptr;
+}
+
+bool KeyboardLayer::init(SDL_Renderer *renderer, const LTexture &keyboard, KeyAtlas &keys, int nKeys) {
+    if (!SDL_RenderTargetSupported(renderer) || !mLayer.createBlank(renderer, keyboard.getWidth(), keyboard.getHeight(), SDL_TEXTUREACCESS_TARGET)) {
+        return false;
+    }
+    // the layer is opaque, copying it over the frame needs no blending
+    mLayer.setBlendMod(SDL_BLENDMODE_NONE);
+
+    mKeyboard = &keyboard;
+    mKeys = &keys;
+    mPressed.assign(nKeys, false);
+    invalidate();
+    return true;
+}
+
+void KeyboardLayer::setPressed(int key, bool pressed) {
+    if (mPressed[key] != pressed) {
+        mPressed[key] = pressed;
+        markDirty(mKeys->bounds(key));
+    }
+}
+
+void KeyboardLayer::invalidate() {
+    mDirty.clear();
+    markDirty({0, 0, mLayer.getWidth(), mLayer.getHeight()});
+}
+
+// Merge *rect* with every dirty region it touches, so no pixel is repainted twice
+void KeyboardLayer::markDirty(SDL_Rect rect) {
+    if (SDL_RectEmpty(&rect)) {
+        return;
+    }
+    for (size_t i = 0; i < mDirty.size(); ) {
+        if (SDL_HasIntersection(&rect, &mDirty[i])) {
+            SDL_UnionRect(&rect, &mDirty[i], &rect);
+            mDirty[i] = mDirty.back();
+            mDirty.pop_back();
+            i = 0;
+        }
+        else {
+            ++i;
+        }
+    }
+    mDirty.push_back(rect);
+}
+
+int KeyboardLayer::refresh(SDL_Renderer *renderer) {
+    if (mDirty.empty()) {
+        return 0;
+    }
+
+    // the regions do not overlap, so all the pressed keys can go on top in one batch
+    mLayer.setAsRenderTarget(renderer);
+    for (auto &region: mDirty) {
+        mKeyboard->render(renderer, region.x, region.y, &region);
+        for (size_t i = 0; i < mPressed.size(); ++i) {
+            if (mPressed[i]) {
+                mKeys->add(i, &region);
+            }
+        }
+    }
+    mKeys->flush(renderer);
+    SDL_SetRenderTarget(renderer, nullptr);
+
+    int nRepainted = mDirty.size();
+    mDirty.clear();
+    return nRepainted;
+}
+
+void KeyboardLayer::render(SDL_Renderer *renderer) const {
+    mLayer.render(renderer, 0, 0);
+}
@@ -0,0 +1,48 @@
+#ifndef KEYBOARDLAYER_H
+#define KEYBOARDLAYER_H
+
+#include <SDL.h>
+#include <vector>
+#include "ltexture.h"
+#include "keyatlas.h"
+
+/**
+ * The keyboard with its pressed keys, composed once into a render target.
+ *
+ * Only the regions of keys whose state changed are repainted into the target,
+ * so a frame costs a single copy of the layer however many keys are held, and
+ * nothing is repainted while the keys stay as they are.
+ */
+class KeyboardLayer {
+    public:
+        KeyboardLayer();
+
+        // Compose *keyboard* into the layer, with *keys*' overlay i drawn while key i
+        // is pressed. Returns false if the renderer cannot draw to textures.
+        bool init(SDL_Renderer *renderer, const LTexture &keyboard, KeyAtlas &keys, int nKeys);
+
+        // Record key *key*'s state, marking its region dirty if it changed
+        void setPressed(int key, bool pressed);
+
+        // Mark the whole layer dirty, e.g. after SDL_RENDER_TARGETS_RESET
+        void invalidate();
+
+        // Repaint the dirty regions; returns how many were repainted. Resets the
+        // render target and viewport, so call it before setting up the frame's viewports.
+        int refresh(SDL_Renderer *renderer);
+
+        // Draw the layer at the top left of the current viewport
+        void render(SDL_Renderer *renderer) const;
+
+    private:
+        const LTexture *mKeyboard;
+        KeyAtlas *mKeys;
+        std::vector<bool> mPressed;
+        // non-overlapping regions waiting to be repainted
+        std::vector<SDL_Rect> mDirty;
+        LTexture mLayer;
+
+        void markDirty(SDL_Rect rect);
+};
+
+#endif // KEYBOARDLAYER_H
@@ -0,0 +1,33 @@
+#include "keyinput.h"
+#include <algorithm>
+
+KeyInput::KeyInput(const std::vector<SDL_Scancode> &scancodes) : mPressed(scancodes.size(), false) {
+    std::fill(mKeys, mKeys + SDL_NUM_SCANCODES, -1);
+    for (size_t i = 0; i < scancodes.size(); ++i) {
+        mKeys[scancodes[i]] = i;
+    }
+}
+
+int KeyInput::key(SDL_Scancode scancode) const {
+    if (scancode < 0 || scancode >= SDL_NUM_SCANCODES) {
+        return -1;
+    }
+    return mKeys[scancode];
+}
+
+int KeyInput::handle(const SDL_KeyboardEvent &e) {
+    int k = key(e.keysym.scancode);
+    if (k < 0 || e.repeat) {
+        return -1;
+    }
+    bool bPressed = e.type == SDL_KEYDOWN;
+    if (mPressed[k] == bPressed) {
+        return -1;
+    }
+    mPressed[k] = bPressed;
+    return k;
+}
+
+bool KeyInput::pressed(int key) const {
+    return mPressed[key];
+}
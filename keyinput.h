@@ -0,0 +1,35 @@
+#ifndef KEYINPUT_H
+#define KEYINPUT_H
+
+#include <SDL.h>
+#include <vector>
+
+/**
+ * Turns SDL_KEYDOWN and SDL_KEYUP events into presses and releases of the
+ * game's keys as the events arrive, instead of polling the keyboard state once
+ * per frame.
+ *
+ * Scancodes map to keys through a table over every scancode, so each event
+ * costs one lookup, and repeats and events for keys already in that state are
+ * dropped.
+ */
+class KeyInput {
+    public:
+        // Key i is played by *scancodes*[i]
+        explicit KeyInput(const std::vector<SDL_Scancode> &scancodes);
+
+        // The key *scancode* plays, or -1
+        int key(SDL_Scancode scancode) const;
+
+        // The key *e* pressed or released, or -1 if it changed none of them
+        int handle(const SDL_KeyboardEvent &e);
+
+        // Whether key *key* is held
+        bool pressed(int key) const;
+
+    private:
+        int mKeys[SDL_NUM_SCANCODES];
+        std::vector<bool> mPressed;
+};
+
+#endif // KEYINPUT_H
@@ -0,0 +1,76 @@
+#include "keylayout.h"
+#include <cstdio>
+#include <cmath>
+
+bool KeyboardSpec::load(const std::string &path) {
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return false;
+    }
+
+    KeyboardSpec spec = *this;
+    struct { const char *name; int *value; } fields[] = {
+        {"gap", &spec.nGap}, {"octave_gap", &spec.nOctaveGap}, {"first", &spec.nFirst}, {"keys", &spec.nKeys},
+        {"left", &spec.nLeft}, {"width", &spec.nWidth}, {"height", &spec.nHeight}
+    };
+    char name[32];
+    bool success = true;
+    while (success && fscanf(file, "%31s", name) == 1) {
+        std::string entry(name);
+        if (entry == "lanes") {
+            for (int i = 0; i < 12 && success; ++i) {
+                success = fscanf(file, "%d", &spec.laneWidths[i]) == 1 && spec.laneWidths[i] > 0;
+            }
+            continue;
+        }
+        success = false;
+        for (const auto &field: fields) {
+            if (entry == field.name) {
+                success = fscanf(file, "%d", field.value) == 1;
+                break;
+            }
+        }
+    }
+    fclose(file);
+
+    success = success && spec.nKeys > 0 && spec.nFirst >= 0 && spec.nFirst < 12 && spec.nHeight > 0 &&
+              spec.nWidth > 0 && spec.nGap >= 0 && spec.nOctaveGap >= 0 && spec.nLeft >= -1;
+    if (success) {
+        *this = spec;
+    }
+    return success;
+}
+
+void KeyLayout::build(const KeyboardSpec &spec, int nWidth) {
+    // where each lane starts and ends in the description's units
+    std::vector<int> starts(spec.nKeys), ends(spec.nKeys);
+    int x = 0;
+    for (int i = 0; i < spec.nKeys; ++i) {
+        int note = (spec.nFirst + i) % 12;
+        if (i > 0) {
+            x += note == 0 ? spec.nOctaveGap : spec.nGap;
+        }
+        starts[i] = x;
+        x += spec.laneWidths[note];
+        ends[i] = x;
+    }
+
+    int nLeft = spec.nLeft >= 0 ? spec.nLeft : (spec.nWidth - x) / 2;
+    double scale = (double)nWidth / spec.nWidth;
+    int nHeight = (int)std::lround(spec.nHeight * scale);
+
+    mLanes.resize(spec.nKeys);
+    for (int i = 0; i < spec.nKeys; ++i) {
+        int x0 = (int)std::lround((nLeft + starts[i]) * scale);
+        int x1 = (int)std::lround((nLeft + ends[i]) * scale);
+        mLanes[i] = {x0, 0, x1 - x0 > 0 ? x1 - x0 : 1, nHeight > 0 ? nHeight : 1};
+    }
+}
+
+const SDL_Rect *KeyLayout::lanes() const {
+    return mLanes.data();
+}
+
+int KeyLayout::size() const {
+    return (int)mLanes.size();
+}
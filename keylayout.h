@@ -0,0 +1,52 @@
+#ifndef KEYLAYOUT_H
+#define KEYLAYOUT_H
+
+#include <SDL.h>
+#include <string>
+#include <vector>
+
+// A keyboard described by one octave of lanes, in the units of a design width.
+// The defaults are the lanes of keyboardClipArt.png.
+struct KeyboardSpec {
+    // lane widths from C to B
+    int laneWidths[12] = {32, 26, 29, 26, 32, 32, 26, 29, 26, 24, 26, 32};
+    // space between neighbouring lanes, and before each C instead
+    int nGap = 2;
+    int nOctaveGap = 7;
+    // the note of the lowest key, 0 for C up to 11 for B, and how many keys follow it
+    int nFirst = 0;
+    int nKeys = 36;
+    // space before the first lane, or -1 to centre the lanes
+    int nLeft = 371;
+    // the width the units are measured in
+    int nWidth = 1897;
+    // the height a tile starts at
+    int nHeight = 100;
+
+    // Read "lanes w0 .. w11", "gap", "octave_gap", "first", "keys", "left", "width" and
+    // "height" entries, keeping the current value of any left out; false, changing
+    // nothing, if the file is missing or describes no keyboard that can be laid out
+    bool load(const std::string &path);
+};
+
+/**
+ * The lanes the keys' tiles fall in, laid out from a KeyboardSpec.
+ *
+ * build() scales the description to the window once, so nothing is laid out
+ * per frame, and keeps the lanes in one array indexed by key. Lane edges are
+ * rounded rather than widths, so the gaps stay even at any scale.
+ */
+class KeyLayout {
+    public:
+        // Lay *spec* out across *nWidth* pixels
+        void build(const KeyboardSpec &spec, int nWidth);
+
+        // Lane i belongs to key i
+        const SDL_Rect *lanes() const;
+        int size() const;
+
+    private:
+        std::vector<SDL_Rect> mLanes;
+};
+
+#endif // KEYLAYOUT_H
@@ -14,6 +14,26 @@ LTexture::~LTexture() {
     free();
 }
 
+LTexture::LTexture(LTexture &&other) {
+    mTexture = other.mTexture;
+    mWidth = other.mWidth;
+    mHeight = other.mHeight;
+    other.mTexture = nullptr;
+    other.mWidth = other.mHeight = 0;
+}
+
+LTexture &LTexture::operator=(LTexture &&other) {
+    if (this != &other) {
+        free();
+        mTexture = other.mTexture;
+        mWidth = other.mWidth;
+        mHeight = other.mHeight;
+        other.mTexture = nullptr;
+        other.mWidth = other.mHeight = 0;
+    }
+    return *this;
+}
+
 void LTexture::free() {
     if (mTexture != nullptr) {
         SDL_DestroyTexture(mTexture);
@@ -30,23 +50,74 @@ bool LTexture::loadFromFile(const std::string &path, SDL_Renderer *renderer, con
         printf("Failed to load image %s. IMG Error: %s\n", path.c_str(), IMG_GetError());
     }
     else {
-        if (colorKey != nullptr) 
-            SDL_SetColorKey( loadedSurface, SDL_TRUE, SDL_MapRGB( loadedSurface->format, colorKey->r, colorKey->g, colorKey->b ) );
-
-        mTexture = SDL_CreateTextureFromSurface(renderer, loadedSurface);
-        if (mTexture == nullptr) {
-            printf("Failed to create texture. SDL Error: %s\n", SDL_GetError());
-        }
-        else {
-            mWidth = loadedSurface->w;
-            mHeight = loadedSurface->h;
-        }
+        loadFromSurface(loadedSurface, renderer, colorKey);
         SDL_FreeSurface(loadedSurface);
     }
 
     return mTexture != nullptr;
 }
 
+bool LTexture::loadFromSurface(SDL_Surface *surface, SDL_Renderer *renderer, const SDL_Color *colorKey /*= nullptr*/) {
+    free();
+
+    if (surface == nullptr) {
+        return false;
+    }
+    if (colorKey != nullptr) 
+        SDL_SetColorKey( surface, SDL_TRUE, SDL_MapRGB( surface->format, colorKey->r, colorKey->g, colorKey->b ) );
+
+    mTexture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (mTexture == nullptr) {
+        printf("Failed to create texture. SDL Error: %s\n", SDL_GetError());
+    }
+    else {
+        mWidth = surface->w;
+        mHeight = surface->h;
+    }
+
+    return mTexture != nullptr;
+}
+
+bool LTexture::loadFromPack(const AssetPack &pack, const std::string &name, SDL_Renderer *renderer) {
+    free();
+
+    const PackImage *image = pack.find(name);
+    if (image == nullptr) {
+        printf("Asset %s is not in the pack.\n", name.c_str());
+        return false;
+    }
+    // the pixels are already RGBA with the key as alpha, so no surface or conversion is needed
+    mTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, image->width, image->height);
+    if (mTexture == nullptr) {
+        printf("Failed to create texture for %s. SDL Error: %s\n", name.c_str(), SDL_GetError());
+        return false;
+    }
+    SDL_UpdateTexture(mTexture, nullptr, image->pixels, image->pitch);
+    SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_BLEND);
+    mWidth = image->width;
+    mHeight = image->height;
+
+    return true;
+}
+
+bool LTexture::createBlank(SDL_Renderer *renderer, int width, int height, SDL_TextureAccess access /*= SDL_TEXTUREACCESS_STREAMING*/) {
+    free();
+
+    mTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, access, width, height);
+    if (mTexture == nullptr) {
+        printf("Failed to create blank texture. SDL Error: %s\n", SDL_GetError());
+    } else {
+        mWidth = width;
+        mHeight = height;
+    }
+
+    return mTexture != nullptr;
+}
+
+void LTexture::setAsRenderTarget(SDL_Renderer *renderer) {
+    SDL_SetRenderTarget(renderer, mTexture);
+}
+
 #ifdef SDL_TTF_MAJOR_VERSION
 bool LTexture::loadFromRenderedText(SDL_Renderer *renderer, TTF_Font *font, const std::string &text, SDL_Color textColor) {
     free();
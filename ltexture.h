@@ -4,11 +4,18 @@
 #include <string>
 #include <SDL.h>
 #include <SDL_ttf.h>
+#include "assetpack.h"
 
 class LTexture {
     public:
         LTexture();
         ~LTexture();
+
+        // Textures are owned by exactly one LTexture, so they move but never copy
+        LTexture(const LTexture&) = delete;
+        LTexture &operator=(const LTexture&) = delete;
+        LTexture(LTexture &&other);
+        LTexture &operator=(LTexture &&other);
        
         // Deallocate the texture
         void free();
@@ -16,6 +23,18 @@ class LTexture {
         // Load image from the specified path with *renderer* as the rendering context
         bool loadFromFile(const std::string &path, SDL_Renderer *renderer, const SDL_Color *colorKey = nullptr);
 
+        // Create the texture from an already decoded *surface*, which stays owned by the caller
+        bool loadFromSurface(SDL_Surface *surface, SDL_Renderer *renderer, const SDL_Color *colorKey = nullptr);
+
+        // Upload the image stored under *name* in *pack* straight from the mapped file
+        bool loadFromPack(const AssetPack &pack, const std::string &name, SDL_Renderer *renderer);
+
+        // Create a blank texture of the given size and access, e.g. SDL_TEXTUREACCESS_TARGET to draw into it
+        bool createBlank(SDL_Renderer *renderer, int width, int height, SDL_TextureAccess access = SDL_TEXTUREACCESS_STREAMING);
+
+        // Make this texture the target of *renderer*'s drawing; it must have been created with SDL_TEXTUREACCESS_TARGET
+        void setAsRenderTarget(SDL_Renderer *renderer);
+
         // Set color modulation
         void setColorMod(uint8_t r, uint8_t g, uint8_t b);
 
@@ -3,17 +3,63 @@
 #include <SDL.h>
 #include "synthesizer.h"
 #include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include "eventqueue.h"
+#include "termkeys.h"
+#ifdef __linux__
+#include <linux/input.h>
+#endif
 
 synth::instrument *voice = nullptr;
+// only the audio thread touches the notes, applying the key events queued for it
 std::vector<synth::note> vecNotes;
+// room for a note per key, so the audio thread never has to grow the vector
+const int MAX_NOTES = 64;
+// ms between key polls while no key is held
+const int IDLE_POLL_MS = 5;
+// ms before handing the audio thread key events that did not fit in its queue again
+const int QUEUE_RETRY_MS = 10;
+
+// key presses and releases, from the input loop to the audio thread
+EventQueue<KeyEvent, 256> keyEvents;
 
-std::mutex muxNotes;
 
 double MakeNoise(double dTime) {
-	std::unique_lock<std::mutex> lm(muxNotes);
+	// start and release the notes of the keys that changed, at this sample
+	KeyEvent event;
+	while (keyEvents.pop(event)) {
+		auto noteFound = std::find_if(vecNotes.begin(), vecNotes.end(), [&event](const synth::note& n) {
+			return n.id == event.key;
+		});
+		if (event.bDown) {
+			// start the note, or restart it if it is still releasing
+			if (noteFound != vecNotes.end()) {
+				vecNotes.erase(noteFound);
+			}
+			vecNotes.push_back(synth::note(event.key, dTime));
+		}
+		// put the note in release mode
+		else if (noteFound != vecNotes.end()) {
+			noteFound->dTimeOff = dTime;
+		}
+	}
+
 	double dOutput = 0.0;
+	bool bFinished = false;
 	for (const auto& n: vecNotes) {
 		dOutput += voice->sound(n, dTime);
+		bFinished |= n.dTimeOff >= n.dTimeOn && dTime - n.dTimeOff > voice->env.dReleaseTime;
+	}
+	if (bFinished) {
+		// erase the notes whose release has finished
+		vecNotes.erase(std::remove_if(vecNotes.begin(), vecNotes.end(), [&dTime](const synth::note& n) {
+			return n.dTimeOff >= n.dTimeOn && dTime - n.dTimeOff > voice->env.dReleaseTime;
+		}), vecNotes.end());
+	}
+	if (vecNotes.empty()) {
+		return 0.0;
 	}
 	return dOutput / vecNotes.size();
 }
@@ -28,6 +74,7 @@ int main(int argc, char* argv[]) {
 	std::wcout << "Using Device: " << devices[0] << '\n' << std::endl;
 
 	// Create sound machine!!
+	vecNotes.reserve(MAX_NOTES);
 	olcNoiseMaker<short> sound(devices[0], 44100, 1, 8, 512);
 
 	// Link noise function with sound machine
@@ -44,42 +91,72 @@ int main(int argc, char* argv[]) {
 				  "|___|___|___|___|___|___|___|___|___|___|\n"
 				  "  A   B   C   D   E   F   G   A   B   C\n";
 	
+#ifdef _WIN32
 	// Add the above keyboard: ZSXCFVGBNJMK,L./, based on virtual key codes:
 	const std::vector<int> keyboard = {0x5A, 0x53, 0x58, 0x43, 0x46, 0x56, 0x47, 0x42, 0x4E, 0x4A, 0x4D, 0x4B, VK_OEM_COMMA, 0x4C, VK_OEM_PERIOD, VK_OEM_2};
+	std::vector<bool> keyHeld(keyboard.size(), false);
 
 	while (true) {
-		double dTimeNow = sound.GetTime();
+		// queue the keys that went down or up since the last poll
+		bool bAnyHeld = false;
 		for (int k = 0; k < int(keyboard.size()); ++k) {
-			auto noteFound = std::find_if(vecNotes.begin(), vecNotes.end(), [&k](const synth::note& n) {
-				return n.id == k;
-			});
-
-			// if the key is pressed
-			if (GetAsyncKeyState(keyboard[k]) & 0x8000) {
-				// if the note has not been active yet, start playing it
-				if (noteFound == vecNotes.end()) {
-					synth::note newNote;
-					newNote.id = k;
-					newNote.dTimeOn = dTimeNow;
-					vecNotes.push_back(newNote);
-				}
-				// if the note is still being active, do nothing as the user simply keeps holding the key
+			bool bDown = (GetAsyncKeyState(keyboard[k]) & 0x8000) != 0;
+			// with the queue full the change is left unrecorded, so the next poll sends it again
+			if (bDown != keyHeld[k] && keyEvents.push(KeyEvent{k, bDown})) {
+				keyHeld[k] = bDown;
 			}
-			else {
-				// if the key is not pressed anymore and the note is still being active
-				if (noteFound != vecNotes.end()) {
-					// either put it in release mode
-					if (noteFound->dTimeOff < noteFound->dTimeOn) {
-						noteFound->dTimeOff = dTimeNow;
-					}
-					// or erase it if its release mode has finished
-					else if (dTimeNow - noteFound->dTimeOff > voice->env.dReleaseTime) {
-						vecNotes.erase(noteFound);
-					}					
-				}
+			bAnyHeld = bAnyHeld || bDown;
+		}
+
+		// the keys can only be polled, so give the core back between polls:
+		// briefly while a key is held, for longer while none is
+		std::this_thread::sleep_for(std::chrono::milliseconds(bAnyHeld ? 1 : IDLE_POLL_MS));
+	}
+#else
+	// Add the above keyboard as the characters the terminal sends, and as evdev key codes:
+#ifdef __linux__
+	const std::vector<int> keyCodes = {KEY_Z, KEY_S, KEY_X, KEY_C, KEY_F, KEY_V, KEY_G, KEY_B, KEY_N, KEY_J, KEY_M, KEY_K, KEY_COMMA, KEY_L, KEY_DOT, KEY_SLASH};
+#else
+	const std::vector<int> keyCodes;
+#endif
+
+	// --evdev /dev/input/eventN reads real key releases from a local keyboard,
+	// --repeat-delay MS and --repeat-gap MS set how long a key is held without them
+	// to just over the terminal's autorepeat delay and interval
+	std::string evdevPath;
+	int nRepeatDelayMs = TermKeys::REPEAT_DELAY_MS;
+	int nRepeatGapMs = TermKeys::REPEAT_GAP_MS;
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (std::string(argv[i]) == "--evdev") {
+			evdevPath = argv[i + 1];
+		}
+		else if (std::string(argv[i]) == "--repeat-delay") {
+			nRepeatDelayMs = std::max(atoi(argv[i + 1]), 1);
+		}
+		else if (std::string(argv[i]) == "--repeat-gap") {
+			nRepeatGapMs = std::max(atoi(argv[i + 1]), 1);
+		}
+	}
+	TermKeys keys("zsxcfvgbnjmk,l./", keyCodes, nRepeatDelayMs, nRepeatGapMs);
+
+	std::wcout << "Press q or Ctrl-C to quit." << std::endl;
+	if (keys.open(evdevPath)) {
+		// sleep in poll() until a key changes, and hand the changes to the audio thread;
+		// those that do not fit are kept, in order, and retried shortly
+		std::vector<KeyEvent> events;
+		while (keys.wait(events, events.empty() ? -1 : QUEUE_RETRY_MS)) {
+			size_t nPushed = 0;
+			while (nPushed < events.size() && keyEvents.push(events[nPushed])) {
+				++nPushed;
 			}
+			events.erase(events.begin(), events.begin() + nPushed);
 		}
+		keys.close();
 	}
+
+	sound.Stop();
+	delete voice;
+#endif
 	
 	return 0;
-}
\ No newline at end of file
+}
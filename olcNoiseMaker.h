@@ -43,6 +43,9 @@
 	  on creating and listening to interesting waveforms.
 	- Currently MS Windows only
 
+	Local changes
+	- Plays through SDL's audio device on platforms other than MS Windows
+
 	Documentation
 	~~~~~~~~~~~~~
 
@@ -54,7 +57,9 @@
 
 
 #pragma once
+#ifdef _WIN32
 #pragma comment(lib, "winmm.lib")
+#endif
 
 #include <iostream>
 #include <cmath>
@@ -64,10 +69,18 @@
 #include <thread>
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <SDL.h>
 
 // for std::find
 #include <algorithm>
+#ifdef _WIN32
+// keep Windows.h from defining min and max over std::min and std::max
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
 #include <Windows.h>
+#endif
 
 const double PI = 2.0 * acos(0.0);
 
@@ -94,11 +107,12 @@ public:
 		m_nBlockSamples = nBlockSamples;
 		m_nBlockFree = m_nBlockCount;
 		m_nBlockCurrent = 0;
+		m_userFunction = nullptr;
+
+#ifdef _WIN32
 		m_pBlockMemory = nullptr;
 		m_pWaveHeaders = nullptr;
 
-		m_userFunction = nullptr;
-
 		// Validate device
 		std::vector<std::wstring> devices = Enumerate();
 		auto d = std::find(devices.begin(), devices.end(), sOutputDevice);
@@ -147,6 +161,37 @@ public:
 		m_cvBlockNotZero.notify_one();
 
 		return true;
+#else
+		// SDL pulls each block from AudioCallback, so no thread of our own is needed
+		m_nDevice = 0;
+		if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0)
+			return Destroy();
+
+		// The first device listed is the system default, which SDL opens by passing no name
+		std::vector<std::wstring> devices = Enumerate();
+		auto d = std::find(devices.begin(), devices.end(), sOutputDevice);
+		std::string sDevice(sOutputDevice.begin(), sOutputDevice.end());
+		const char *pDevice = (d == devices.end() || d == devices.begin()) ? nullptr : sDevice.c_str();
+
+		SDL_AudioSpec want;
+		SDL_zero(want);
+		want.freq = m_nSampleRate;
+		want.format = sizeof(T) == 1 ? AUDIO_S8 : sizeof(T) == 2 ? AUDIO_S16SYS : AUDIO_S32SYS;
+		want.channels = m_nChannels;
+		want.samples = m_nBlockSamples;
+		want.callback = AudioCallbackWrap;
+		want.userdata = this;
+
+		// No allowed changes, so SDL converts to whatever the hardware wants
+		m_nSampleClock = 0;
+		m_nDevice = SDL_OpenAudioDevice(pDevice, 0, &want, nullptr, 0);
+		if (m_nDevice == 0)
+			return Destroy();
+
+		m_bReady = true;
+		SDL_PauseAudioDevice(m_nDevice, 0);
+		return true;
+#endif
 	}
 
 	bool Destroy()
@@ -157,7 +202,12 @@ public:
 	void Stop()
 	{
 		m_bReady = false;
+#ifdef _WIN32
 		m_thread.join();
+#else
+		// Waits for a callback in progress to return
+		SDL_CloseAudioDevice(m_nDevice);
+#endif
 	}
 
 	// Override to process current sample
@@ -166,9 +216,42 @@ public:
 		return 0.0;
 	}
 
+	// Audio time in seconds, interpolated from the last published block with the
+	// performance counter so it advances smoothly between blocks
 	double GetTime()
 	{
-		return m_dGlobalTime;
+		uint64_t nSamples, nCounter;
+		GetClock(nSamples, nCounter);
+		if (nCounter == 0)
+			return 0.0;
+
+		double dElapsed = (double)(SDL_GetPerformanceCounter() - nCounter) / (double)SDL_GetPerformanceFrequency();
+		double dBlockTime = (double)m_nBlockSamples / (double)m_nSampleRate;
+		return (double)nSamples / (double)m_nSampleRate + fmin(dElapsed, dBlockTime);
+	}
+
+	// Samples rendered so far, and the performance counter when the block that
+	// completed them was handed to the soundcard
+	void GetClock(uint64_t &nSamples, uint64_t &nCounter)
+	{
+		unsigned int nSequence;
+		do
+		{
+			nSequence = m_nClockSequence.load(std::memory_order_acquire);
+			nSamples = m_nClockSamples.load(std::memory_order_relaxed);
+			nCounter = m_nClockCounter.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+		} while ((nSequence & 1) || nSequence != m_nClockSequence.load(std::memory_order_relaxed));
+	}
+
+	unsigned int GetSampleRate() const
+	{
+		return m_nSampleRate;
+	}
+
+	unsigned int GetBlockSamples() const
+	{
+		return m_nBlockSamples;
 	}
 
 	
@@ -176,6 +259,7 @@ public:
 public:
 	static std::vector<std::wstring> Enumerate()
 	{
+#ifdef _WIN32
 		int nDeviceCount = waveOutGetNumDevs();
 		std::vector<std::wstring> sDevices;
 		WAVEOUTCAPS woc;
@@ -197,6 +281,24 @@ public:
 			std::cerr << "Error here." << std::endl;
 		}
 		return sDevices;
+#else
+		// Listed after the system default, since some audio servers name no devices at all
+		std::vector<std::wstring> sDevices{L"Default"};
+		if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0)
+			return sDevices;
+		int nDeviceCount = SDL_GetNumAudioDevices(0);
+		for (int n = 0; n < nDeviceCount; n++)
+		{
+			const char *pName = SDL_GetAudioDeviceName(n, 0);
+			if (pName != nullptr)
+			{
+				std::string tmp(pName);
+				sDevices.push_back(std::wstring(tmp.begin(), tmp.end()));
+			}
+		}
+		SDL_QuitSubSystem(SDL_INIT_AUDIO);
+		return sDevices;
+#endif
 	}
 
 	void SetUserFunction(double(*func)(double))
@@ -222,9 +324,15 @@ private:
 	unsigned int m_nBlockSamples;
 	unsigned int m_nBlockCurrent;
 
+#ifdef _WIN32
 	T* m_pBlockMemory;
 	WAVEHDR *m_pWaveHeaders;
 	HWAVEOUT m_hwDevice;
+#else
+	SDL_AudioDeviceID m_nDevice;
+	// Only the audio callback advances it once the device is open
+	uint64_t m_nSampleClock;
+#endif
 
 	std::thread m_thread;
 	std::atomic<bool> m_bReady;
@@ -232,8 +340,45 @@ private:
 	std::condition_variable m_cvBlockNotZero;
 	std::mutex m_muxBlockNotZero;
 
-	std::atomic<double> m_dGlobalTime;
+	// Sample clock published once per block; the sequence is odd while it is being written
+	std::atomic<unsigned int> m_nClockSequence{0};
+	std::atomic<uint64_t> m_nClockSamples{0};
+	std::atomic<uint64_t> m_nClockCounter{0};
+
+	void PublishClock(uint64_t nSamples)
+	{
+		unsigned int nSequence = m_nClockSequence.load(std::memory_order_relaxed);
+		m_nClockSequence.store(nSequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_nClockSamples.store(nSamples, std::memory_order_relaxed);
+		m_nClockCounter.store(SDL_GetPerformanceCounter(), std::memory_order_relaxed);
+		m_nClockSequence.store(nSequence + 2, std::memory_order_release);
+	}
+
+	// Fill *nSamples* samples at *pBlock* from the user function, counting them on *nSampleClock*
+	void FillBlock(T *pBlock, unsigned int nSamples, uint64_t &nSampleClock)
+	{
+		double dSampleRate = (double)m_nSampleRate;
+
+		// Goofy hack to get maximum integer for a type at run-time
+		T nMaxSample = (T)pow(2, (sizeof(T) * 8) - 1) - 1;
+		double dMaxSample = (double)nMaxSample;
 
+		for (unsigned int n = 0; n < nSamples; n++)
+		{
+			double dTime = (double)nSampleClock / dSampleRate;
+
+			// User Process
+			if (m_userFunction == nullptr)
+				pBlock[n] = (T)(clip(UserProcess(dTime), 1.0) * dMaxSample);
+			else
+				pBlock[n] = (T)(clip(m_userFunction(dTime), 1.0) * dMaxSample);
+
+			nSampleClock++;
+		}
+	}
+
+#ifdef _WIN32
 	// Handler for soundcard request for more data
 	void waveOutProc(HWAVEOUT hWaveOut, UINT uMsg, DWORD dwParam1, DWORD dwParam2)
 	{
@@ -256,13 +401,9 @@ private:
 	// and then issued to the soundcard.
 	void MainThread()
 	{
-		m_dGlobalTime = 0.0;
-		double dTimeStep = 1.0 / (double)m_nSampleRate;
-
-		// Goofy hack to get maximum integer for a type at run-time
-		T nMaxSample = (T)pow(2, (sizeof(T) * 8) - 1) - 1;
-		double dMaxSample = (double)nMaxSample;
-		T nPreviousSample = 0;
+		// Counted in whole samples so the time never drifts, and kept local so the
+		// inner loop touches no atomics
+		uint64_t nSampleClock = 0;
 
 		while (m_bReady)
 		{
@@ -280,28 +421,28 @@ private:
 			if (m_pWaveHeaders[m_nBlockCurrent].dwFlags & WHDR_PREPARED)
 				waveOutUnprepareHeader(m_hwDevice, &m_pWaveHeaders[m_nBlockCurrent], sizeof(WAVEHDR));
 
-			T nNewSample = 0;
-			int nCurrentBlock = m_nBlockCurrent * m_nBlockSamples;
-			
-			for (unsigned int n = 0; n < m_nBlockSamples; n++)
-			{
-				// User Process
-				if (m_userFunction == nullptr)
-					nNewSample = (T)(clip(UserProcess(m_dGlobalTime), 1.0) * dMaxSample);
-				else
-					nNewSample = (T)(clip(m_userFunction(m_dGlobalTime), 1.0) * dMaxSample);
-
-				m_pBlockMemory[nCurrentBlock + n] = nNewSample;
-				nPreviousSample = nNewSample;
-				m_dGlobalTime = m_dGlobalTime + dTimeStep;
-			}
+			FillBlock(m_pBlockMemory + m_nBlockCurrent * m_nBlockSamples, m_nBlockSamples, nSampleClock);
 
 			// Send block to sound device
 			waveOutPrepareHeader(m_hwDevice, &m_pWaveHeaders[m_nBlockCurrent], sizeof(WAVEHDR));
 			waveOutWrite(m_hwDevice, &m_pWaveHeaders[m_nBlockCurrent], sizeof(WAVEHDR));
+			PublishClock(nSampleClock);
 			m_nBlockCurrent++;
 			m_nBlockCurrent %= m_nBlockCount;
 		}
 	}
+#else
+	// SDL's audio thread asking for the next block
+	void AudioCallback(T *pBlock, unsigned int nSamples)
+	{
+		FillBlock(pBlock, nSamples, m_nSampleClock);
+		PublishClock(m_nSampleClock);
+	}
+
+	static void SDLCALL AudioCallbackWrap(void *pUserData, Uint8 *pStream, int nLength)
+	{
+		((olcNoiseMaker*)pUserData)->AudioCallback((T*)pStream, nLength / sizeof(T));
+	}
+#endif
 };
 #endif // OLCNOISEMAKE_H
\ No newline at end of file
@@ -0,0 +1,129 @@
+// Bakes images into an asset pack (see assetpack.h) so the game can skip decoding at startup.
+//
+// usage: packtool out.pak [--key RRGGBB | --no-key] image...
+//
+// Images are stored under the path they are given by, so run it from the game's
+// directory, e.g.
+//   packtool graphic_files/assets.pak graphic_files/keyboardClipArt.png --key FFFFFF graphic_files/individual_keys/*.png
+// A --key turns that color transparent in every image after it, until --no-key.
+#include <SDL.h>
+#include <SDL_image.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "assetpack.h"
+
+// pixel data of every image starts on this boundary
+const uint64_t nPackAlignment = 16;
+
+struct PackInput {
+    std::string path;
+    bool bKeyed;
+    SDL_Color key;
+};
+
+// Decode *input* into a tightly pitched RGBA32 surface with the key made transparent
+SDL_Surface *decode(const PackInput &input) {
+    SDL_Surface *loaded = IMG_Load(input.path.c_str());
+    if (loaded == nullptr) {
+        printf("Failed to load image %s. IMG Error: %s\n", input.path.c_str(), IMG_GetError());
+        return nullptr;
+    }
+    SDL_Surface *surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if (surface == nullptr) {
+        printf("Failed to convert image %s. SDL Error: %s\n", input.path.c_str(), SDL_GetError());
+        return nullptr;
+    }
+    if (input.bKeyed) {
+        for (int y = 0; y < surface->h; ++y) {
+            Uint8 *pixel = (Uint8*)surface->pixels + y * surface->pitch;
+            for (int x = 0; x < surface->w; ++x, pixel += 4) {
+                if (pixel[0] == input.key.r && pixel[1] == input.key.g && pixel[2] == input.key.b) {
+                    pixel[3] = 0;
+                }
+            }
+        }
+    }
+    return surface;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        printf("usage: %s out.pak [--key RRGGBB | --no-key] image...\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<PackInput> inputs;
+    bool bKeyed = false;
+    SDL_Color key{0, 0, 0, 0xFF};
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--key") == 0 && i + 1 < argc) {
+            unsigned long rgb = strtoul(argv[++i], nullptr, 16);
+            key = {(Uint8)(rgb >> 16), (Uint8)(rgb >> 8), (Uint8)rgb, 0xFF};
+            bKeyed = true;
+        } else if (strcmp(argv[i], "--no-key") == 0) {
+            bKeyed = false;
+        } else if (strlen(argv[i]) >= sizeof(PackEntry::name)) {
+            printf("Image path %s is too long to pack.\n", argv[i]);
+            return 1;
+        } else {
+            inputs.push_back({argv[i], bKeyed, key});
+        }
+    }
+
+    // index first, then the pixels of each image in order
+    std::vector<PackEntry> entries(inputs.size());
+    std::vector<SDL_Surface*> surfaces(inputs.size(), nullptr);
+    uint64_t nOffset = sizeof(PackHeader) + entries.size() * sizeof(PackEntry);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        surfaces[i] = decode(inputs[i]);
+        if (surfaces[i] == nullptr) {
+            return 1;
+        }
+        PackEntry &entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        strncpy(entry.name, inputs[i].path.c_str(), sizeof(entry.name) - 1);
+        entry.width = surfaces[i]->w;
+        entry.height = surfaces[i]->h;
+        entry.pitch = surfaces[i]->w * 4;
+        nOffset = (nOffset + nPackAlignment - 1) / nPackAlignment * nPackAlignment;
+        entry.offset = nOffset;
+        nOffset += (uint64_t)entry.pitch * entry.height;
+    }
+
+    FILE *file = fopen(argv[1], "wb");
+    if (file == nullptr) {
+        printf("Failed to open %s for writing.\n", argv[1]);
+        return 1;
+    }
+    PackHeader header;
+    memcpy(header.magic, PACK_MAGIC, 4);
+    header.version = PACK_VERSION;
+    header.count = entries.size();
+    header.reserved = 0;
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(entries.data(), sizeof(PackEntry), entries.size(), file);
+
+    const char zeros[nPackAlignment] = {};
+    for (size_t i = 0; i < entries.size(); ++i) {
+        long nPosition = ftell(file);
+        fwrite(zeros, 1, entries[i].offset - nPosition, file);
+        // SDL may pad the surface's rows, the pack never does
+        for (int y = 0; y < surfaces[i]->h; ++y) {
+            fwrite((Uint8*)surfaces[i]->pixels + y * surfaces[i]->pitch, 1, entries[i].pitch, file);
+        }
+        SDL_FreeSurface(surfaces[i]);
+    }
+    bool bSuccess = ferror(file) == 0;
+    fclose(file);
+
+    if (!bSuccess) {
+        printf("Failed to write %s.\n", argv[1]);
+        return 1;
+    }
+    printf("Packed %d images into %s (%llu bytes).\n", (int)entries.size(), argv[1], (unsigned long long)nOffset);
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "playfield.h"
+#include <cstdio>
+
+Playfield::Playfield() {
+    mTexture = nullptr;
+    mFormat = nullptr;
+    mCpu = false;
+    mWidth = mHeight = 0;
+    mBackground = {0xFF, 0xFF, 0xFF, 0xFF};
+}
+
+Playfield::~Playfield() {
+    free();
+}
+
+void Playfield::free() {
+    if (mTexture != nullptr) {
+        SDL_DestroyTexture(mTexture);
+        mTexture = nullptr;
+    }
+    if (mFormat != nullptr) {
+        SDL_FreeFormat(mFormat);
+        mFormat = nullptr;
+    }
+    mWidth = mHeight = 0;
+}
+
+bool Playfield::init(SDL_Renderer *renderer, int width, int height, SDL_Color background, bool cpu) {
+    free();
+    mCpu = cpu;
+    mBackground = background;
+    mWidth = width;
+    mHeight = height;
+    // the renderer draws the tiles itself, so there is nothing to create
+    if (!cpu) {
+        return true;
+    }
+
+    // the software renderer's native format, so copying the texture needs no conversion
+    mTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (mTexture == nullptr) {
+        printf("Failed to create playfield texture. SDL Error: %s\n", SDL_GetError());
+        mCpu = false;
+        return false;
+    }
+    mFormat = SDL_AllocFormat(SDL_PIXELFORMAT_ARGB8888);
+    return true;
+}
+
+SDL_Rect Playfield::scaledRect(double scale) const {
+    int w = (int)(mWidth * scale + 0.5), h = (int)(mHeight * scale + 0.5);
+    return {0, 0, w < 1 ? 1 : (w > mWidth ? mWidth : w), h < 1 ? 1 : (h > mHeight ? mHeight : h)};
+}
+
+int Playfield::render(SDL_Renderer *renderer, TileBatch &batch, double scale /*= 1.0*/) {
+    // the renderer draws the tiles itself, at full resolution
+    if (!mCpu) {
+        return batch.flush(renderer);
+    }
+
+    SDL_Rect dst{0, 0, mWidth, mHeight};
+    SDL_Rect src = scaledRect(scale);
+    void *pixels;
+    int pitch;
+    if (SDL_LockTexture(mTexture, &src, &pixels, &pitch) != 0) {
+        printf("Failed to lock playfield texture. SDL Error: %s\n", SDL_GetError());
+        return 0;
+    }
+    // a locked texture's old contents are undefined, so every pixel is rewritten
+    Uint32 background = SDL_MapRGBA(mFormat, mBackground.r, mBackground.g, mBackground.b, 0xFF);
+    for (int y = 0; y < src.h; ++y) {
+        fillRow((Uint32*)((Uint8*)pixels + y * pitch), src.w, background);
+    }
+    batch.rasterize((Uint32*)pixels, pitch, src.w, src.h, mFormat, (double)src.w / mWidth, (double)src.h / mHeight);
+    SDL_UnlockTexture(mTexture);
+
+    SDL_RenderCopy(renderer, mTexture, &src, &dst);
+    return 1;
+}
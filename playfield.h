@@ -0,0 +1,46 @@
+#ifndef PLAYFIELD_H
+#define PLAYFIELD_H
+
+#include <SDL.h>
+#include "tilebatch.h"
+
+/**
+ * Draws the tiles, on the CPU path optionally at a reduced resolution that is
+ * scaled up to the full playfield in a single copy.
+ *
+ * On the CPU path, for renderers without a GPU where SDL's software renderer
+ * handles many filled rects slowly, the tiles are painted into a streaming
+ * texture: each frame it is locked, cleared and the batch's rects are filled
+ * in as row spans, so the cost follows the area painted rather than the
+ * number of tiles. Otherwise the batch is drawn by the renderer at full
+ * resolution, and no texture is made.
+ */
+class Playfield {
+    public:
+        Playfield();
+        ~Playfield();
+
+        // Set up a *width* x *height* playfield cleared to *background* each frame;
+        // *cpu* picks the CPU path and creates its texture. Returns false if the texture
+        // could not be made, in which case the tiles are drawn by the renderer instead.
+        bool init(SDL_Renderer *renderer, int width, int height, SDL_Color background, bool cpu);
+
+        // Free the texture
+        void free();
+
+        // Draw the queued tiles of *batch*, on the CPU path at *scale* of full resolution,
+        // emptying it, into the top left of the current viewport; returns the draw calls made
+        int render(SDL_Renderer *renderer, TileBatch &batch, double scale = 1.0);
+
+    private:
+        SDL_Texture *mTexture;
+        SDL_PixelFormat *mFormat;
+        bool mCpu;
+        int mWidth, mHeight;
+        SDL_Color mBackground;
+
+        // The playfield at *scale*, in texture pixels
+        SDL_Rect scaledRect(double scale) const;
+};
+
+#endif // PLAYFIELD_H
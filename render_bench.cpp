@@ -0,0 +1,284 @@
+// Headless benchmark of the game's frame: falling tiles plus the keyboard layer,
+// drawn by SDL's software renderer under the dummy video driver, so no GPU or
+// display is needed.
+//
+// usage: render_bench [frames] [--cpu-tiles]
+//
+// Every scene keeps a steady number of tiles alive while a pattern of keys is
+// held, and prints one JSON object per line with the frame-time percentiles and
+// histogram and the draw calls per frame, e.g.
+//   render_bench > bench_output.txt
+// Scenes advance a fixed 1/60 s of game time per frame, so runs are comparable.
+#include <SDL.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "ltexture.h"
+#include "tilebatch.h"
+#include "tilepool.h"
+#include "keyatlas.h"
+#include "keyboardlayer.h"
+#include "playfield.h"
+#include "keylayout.h"
+
+const int SCREEN_WIDTH = 1897;
+const int SCREEN_HEIGHT = 720;
+const int KEYBOARD_HEIGHT = 200;
+const int KEYBOARD_SIZE = 12 * 3;
+const double TILE_SPEED = 300.0;
+const double FRAME_TIME = 1.0 / 60.0;
+// how long each tile's key is held
+const double TILE_LENGTH = 0.1;
+const int WARMUP_FRAMES = 60;
+
+// upper edges of the frame-time histogram's buckets in ms; the last one is open
+const double HISTOGRAM_EDGES[] = {0.25, 0.5, 1.0, 2.0, 4.0, 8.0, 16.7, 33.3};
+const int HISTOGRAM_SIZE = sizeof(HISTOGRAM_EDGES) / sizeof(HISTOGRAM_EDGES[0]) + 1;
+
+enum KeyPattern {
+    KEYS_NONE,
+    KEYS_CHORD,
+    KEYS_ALL,
+    KEYS_TRILL,
+    KEYS_SWEEP
+};
+const char *KEY_PATTERN_NAMES[] = {"none", "chord", "all", "trill", "sweep"};
+
+// Whether key *key* is held in frame *frame* of *pattern*
+bool held(KeyPattern pattern, int key, int frame) {
+    switch (pattern) {
+        case KEYS_CHORD:
+            return key == 0 || key == 4 || key == 7;
+        case KEYS_ALL:
+            return true;
+        case KEYS_TRILL:
+            // two keys alternating every frame, so the layer repaints each frame
+            return key == frame % 2;
+        case KEYS_SWEEP:
+            return key == frame % KEYBOARD_SIZE;
+        default:
+            return false;
+    }
+}
+
+// A stand-in for the keyboard art: every lane is a key, and overlay i is
+// color-keyed white except over key i
+void makeKeyboard(const SDL_Rect *lanes, SDL_Surface* &keyboard, std::vector<SDL_Surface*> &overlays) {
+    keyboard = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, KEYBOARD_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32);
+    SDL_FillRect(keyboard, nullptr, SDL_MapRGB(keyboard->format, 0x40, 0x40, 0x40));
+    for (int i = 0; i < KEYBOARD_SIZE; ++i) {
+        SDL_Rect key{lanes[i].x, 0, lanes[i].w, KEYBOARD_HEIGHT};
+        SDL_FillRect(keyboard, &key, SDL_MapRGB(keyboard->format, 0xF0, 0xF0, 0xF0));
+
+        SDL_Surface *overlay = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, KEYBOARD_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32);
+        SDL_FillRect(overlay, nullptr, SDL_MapRGB(overlay->format, 0xFF, 0xFF, 0xFF));
+        SDL_FillRect(overlay, &key, SDL_MapRGB(overlay->format, 0x80, 0x80, 0xC0));
+        overlays.push_back(overlay);
+    }
+}
+
+struct SceneResult {
+    std::vector<double> frameTimes;
+    long long nDrawCalls;
+    int nTilesAlive;
+};
+
+// Run *nFrames* frames with about *nTiles* tiles alive and *pattern* held
+SceneResult runScene(SDL_Renderer *renderer, const SDL_Rect *lanes, const LTexture &keyboardTexture, KeyAtlas &keyAtlas,
+                     int nTiles, KeyPattern pattern, int nFrames, bool bCpuTiles) {
+    SDL_Rect bottomViewport{0, SCREEN_HEIGHT - KEYBOARD_HEIGHT, SCREEN_WIDTH, KEYBOARD_HEIGHT};
+    SDL_Rect topViewport{0, 0, SCREEN_WIDTH, SCREEN_HEIGHT - KEYBOARD_HEIGHT};
+    const std::vector<SDL_Color> palette = {{0xff, 0, 0, 0xff}, {0, 0xff, 0, 0xff}, {0, 0, 0xff, 0xff}};
+
+    KeyboardLayer keyboardLayer;
+    bool bKeyboardLayer = keyboardLayer.init(renderer, keyboardTexture, keyAtlas, KEYBOARD_SIZE);
+    TilePool tiles(TILE_SPEED, lanes[0].h);
+    TileBatch tileBatch(palette);
+    Playfield playfield;
+    if (bCpuTiles) {
+        playfield.init(renderer, topViewport.w, topViewport.h, SDL_Color{0xFF, 0xFF, 0xFF, 0xFF}, true);
+    }
+
+    // a tile lives from its press until its top leaves the playfield; spacing
+    // the presses by a share of that keeps nTiles alive in the steady state
+    double dLifetime = TILE_LENGTH + topViewport.h / TILE_SPEED;
+    double dSpawnInterval = nTiles > 0 ? dLifetime / nTiles : 0.0;
+    double dNextSpawn = 0.0;
+    int nSpawned = 0;
+    // start with the pool already full
+    double dTime = nTiles > 0 ? dLifetime : 0.0;
+
+    SceneResult result;
+    result.nDrawCalls = 0;
+    double dCounterPeriod = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    for (int frame = -WARMUP_FRAMES; frame < nFrames; ++frame) {
+        Uint64 nStart = SDL_GetPerformanceCounter();
+        int nDrawCalls = 0;
+
+        while (nTiles > 0 && dNextSpawn <= dTime) {
+            int lane = nSpawned % KEYBOARD_SIZE;
+            int handle = tiles.open(lane, lane % palette.size(), dNextSpawn);
+            tiles.close(handle, dNextSpawn + TILE_LENGTH);
+            ++nSpawned;
+            dNextSpawn += dSpawnInterval;
+        }
+        tiles.update(dTime, topViewport.h);
+
+        // the same order of work as graphic.cpp's frame
+        if (bKeyboardLayer) {
+            for (int i = 0; i < KEYBOARD_SIZE; ++i) {
+                keyboardLayer.setPressed(i, held(pattern, i, frame));
+            }
+            // a copy per repainted region, plus the region's keys in one batch
+            int nRepainted = keyboardLayer.refresh(renderer);
+            nDrawCalls += nRepainted > 0 ? nRepainted + 1 : 0;
+        }
+
+        SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+        SDL_RenderClear(renderer);
+        ++nDrawCalls;
+
+        SDL_RenderSetViewport(renderer, &bottomViewport);
+        if (bKeyboardLayer) {
+            keyboardLayer.render(renderer);
+            ++nDrawCalls;
+        }
+        else {
+            keyboardTexture.render(renderer, 0, 0);
+            ++nDrawCalls;
+            for (int i = 0; i < KEYBOARD_SIZE; ++i) {
+                if (held(pattern, i, frame)) {
+                    keyAtlas.add(i);
+                }
+            }
+            nDrawCalls += keyAtlas.flush(renderer);
+        }
+
+        SDL_RenderSetViewport(renderer, &topViewport);
+        tiles.draw(tileBatch, lanes);
+        if (bCpuTiles) {
+            playfield.render(renderer, tileBatch);
+            ++nDrawCalls;
+        }
+        else {
+            nDrawCalls += tileBatch.flush(renderer);
+        }
+
+        SDL_RenderPresent(renderer);
+        dTime += FRAME_TIME;
+
+        if (frame >= 0) {
+            result.frameTimes.push_back((SDL_GetPerformanceCounter() - nStart) * dCounterPeriod);
+            result.nDrawCalls += nDrawCalls;
+        }
+    }
+    result.nTilesAlive = tiles.size();
+    return result;
+}
+
+// Nearest-rank percentile *p* of the sorted *times*
+double percentile(const std::vector<double> &times, double p) {
+    if (times.empty()) {
+        return 0.0;
+    }
+    size_t rank = (size_t)(p / 100.0 * times.size() + 0.5);
+    return times[std::min(std::max(rank, (size_t)1), times.size()) - 1];
+}
+
+int main(int argc, char *argv[]) {
+    int nFrames = 600;
+    bool bCpuTiles = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--cpu-tiles") {
+            bCpuTiles = true;
+        }
+        else {
+            nFrames = atoi(argv[i]);
+        }
+    }
+    if (nFrames <= 0) {
+        printf("usage: %s [frames] [--cpu-tiles]\n", argv[0]);
+        return 1;
+    }
+
+    // headless unless the caller asks for a real driver
+    if (SDL_getenv("SDL_VIDEODRIVER") == nullptr) {
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    }
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        printf("Failed to initialise SDL. SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    SDL_Window *window = SDL_CreateWindow("render_bench", 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, 0);
+    SDL_Renderer *renderer = window == nullptr ? nullptr : SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE);
+    if (renderer == nullptr) {
+        printf("Failed to create a software renderer. SDL Error: %s\n", SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+
+    // the game's own lanes
+    KeyLayout keyLayout;
+    keyLayout.build(KeyboardSpec(), SCREEN_WIDTH);
+    const SDL_Rect *lanes = keyLayout.lanes();
+    SDL_Surface *keyboard = nullptr;
+    std::vector<SDL_Surface*> overlays;
+    makeKeyboard(lanes, keyboard, overlays);
+    LTexture keyboardTexture;
+    keyboardTexture.loadFromSurface(keyboard, renderer);
+    SDL_Color colorKey{0xFF, 0xFF, 0xFF, 0xFF};
+    KeyAtlas keyAtlas;
+    keyAtlas.build(renderer, overlays, &colorKey);
+    SDL_FreeSurface(keyboard);
+    for (auto overlay: overlays) {
+        SDL_FreeSurface(overlay);
+    }
+
+    const int tileCounts[] = {0, 100, 1000, 10000};
+    const KeyPattern patterns[] = {KEYS_NONE, KEYS_CHORD, KEYS_ALL, KEYS_TRILL, KEYS_SWEEP};
+    for (int nTiles: tileCounts) {
+        for (KeyPattern pattern: patterns) {
+            SceneResult result = runScene(renderer, lanes, keyboardTexture, keyAtlas, nTiles, pattern, nFrames, bCpuTiles);
+            std::vector<double> &times = result.frameTimes;
+            std::sort(times.begin(), times.end());
+
+            int histogram[HISTOGRAM_SIZE] = {};
+            double dTotal = 0.0;
+            for (double t: times) {
+                int bucket = 0;
+                while (bucket < HISTOGRAM_SIZE - 1 && t > HISTOGRAM_EDGES[bucket]) {
+                    ++bucket;
+                }
+                ++histogram[bucket];
+                dTotal += t;
+            }
+
+            std::string buckets;
+            for (int b = 0; b < HISTOGRAM_SIZE; ++b) {
+                buckets += (b ? "," : "") + std::to_string(histogram[b]);
+            }
+            printf("{\"tiles\": %d, \"keys\": \"%s\", \"tile_path\": \"%s\", \"frames\": %d, \"tiles_alive\": %d, "
+                   "\"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f, "
+                   "\"draw_calls_per_frame\": %.2f, \"histogram\": [%s]}\n",
+                   nTiles, KEY_PATTERN_NAMES[pattern], bCpuTiles ? "cpu" : "renderer", nFrames, result.nTilesAlive,
+                   dTotal / nFrames, percentile(times, 50.0), percentile(times, 95.0), percentile(times, 99.0), times.back(),
+                   (double)result.nDrawCalls / nFrames, buckets.c_str());
+            fflush(stdout);
+        }
+    }
+
+    std::string edges;
+    for (int b = 0; b < HISTOGRAM_SIZE - 1; ++b) {
+        edges += (b ? "," : "") + std::to_string(HISTOGRAM_EDGES[b]);
+    }
+    printf("{\"histogram_edges_ms\": [%s], \"renderer\": \"software\", \"video_driver\": \"%s\"}\n", edges.c_str(), SDL_GetCurrentVideoDriver());
+
+    keyboardTexture.free();
+    keyAtlas.free();
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 0;
+}
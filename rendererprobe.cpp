@@ -0,0 +1,160 @@
+#include "rendererprobe.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+const int nProbeWarmup = 3;
+const int nProbeFrames = 20;
+const int nProbeBatches = 3;
+const int nProbeTiles = 1000;
+// the software renderer is only picked over an accelerated one if it takes at most this fraction of its time
+const double dSoftwareMargin = 0.5;
+
+double probeRenderDriver(SDL_Window *window, int index) {
+    SDL_Renderer *renderer = SDL_CreateRenderer(window, index, 0);
+    if (renderer == nullptr) {
+        return -1.0;
+    }
+
+    // a keyboard-sized texture to blit, and tiles spread over the lanes in three colors
+    SDL_Texture *keyboard = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, 1024, 256);
+    if (keyboard == nullptr) {
+        SDL_DestroyRenderer(renderer);
+        return -1.0;
+    }
+    std::vector<Uint32> pixels(1024 * 256, 0xFF808080);
+    SDL_UpdateTexture(keyboard, nullptr, pixels.data(), 1024 * 4);
+    std::vector<SDL_Rect> tiles[3];
+    for (int i = 0; i < nProbeTiles; ++i) {
+        tiles[i % 3].push_back({(i % 36) * 32, (i * 7) % 400, 30, 40 + i % 60});
+    }
+
+    auto drawFrame = [&]() {
+        SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+        SDL_RenderClear(renderer);
+        SDL_Rect dst{0, 464, 1024, 256};
+        SDL_RenderCopy(renderer, keyboard, nullptr, &dst);
+        for (int c = 0; c < 3; ++c) {
+            SDL_SetRenderDrawColor(renderer, c == 0 ? 0xFF : 0, c == 1 ? 0xFF : 0, c == 2 ? 0xFF : 0, 0xFF);
+            SDL_RenderFillRects(renderer, tiles[c].data(), (int)tiles[c].size());
+        }
+    };
+    // reading a pixel back waits for the driver to finish drawing, without presenting
+    auto finish = [&]() {
+        Uint32 pixel;
+        SDL_Rect probe{0, 0, 1, 1};
+        return SDL_RenderReadPixels(renderer, &probe, SDL_PIXELFORMAT_RGBA32, &pixel, 4) == 0;
+    };
+
+    for (int frame = 0; frame < nProbeWarmup; ++frame) {
+        drawFrame();
+    }
+    bool success = finish();
+
+    // the readback stalls a GPU driver far longer than a frame's drawing, so it
+    // ends a whole batch of frames rather than each one
+    std::vector<double> times;
+    double dCounterPeriod = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    for (int batch = 0; batch < nProbeBatches && success; ++batch) {
+        Uint64 nStart = SDL_GetPerformanceCounter();
+        for (int frame = 0; frame < nProbeFrames; ++frame) {
+            drawFrame();
+        }
+        success = finish();
+        times.push_back((SDL_GetPerformanceCounter() - nStart) * dCounterPeriod / nProbeFrames);
+    }
+
+    SDL_DestroyTexture(keyboard);
+    SDL_DestroyRenderer(renderer);
+    if (!success) {
+        return -1.0;
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// The index of the render driver called *name*, or -1
+static int findRenderDriver(const std::string &name) {
+    for (int i = 0; i < SDL_GetNumRenderDrivers(); ++i) {
+        SDL_RendererInfo info;
+        if (SDL_GetRenderDriverInfo(i, &info) == 0 && name == info.name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+SDL_Renderer *createBestRenderer(SDL_Window *window, bool vsync, const std::string &driver, const std::string &cacheFile) {
+    Uint32 flags = vsync ? SDL_RENDERER_PRESENTVSYNC : 0;
+
+    // an explicit driver, or else the one chosen on an earlier run
+    std::string name = driver == "auto" ? "" : driver;
+    if (name.empty()) {
+        FILE *file = fopen(cacheFile.c_str(), "r");
+        if (file != nullptr) {
+            char cached[64];
+            if (fscanf(file, "driver %63s", cached) == 1) {
+                name = cached;
+            }
+            fclose(file);
+        }
+    }
+    if (!name.empty() && name != "probe") {
+        int index = findRenderDriver(name);
+        if (index < 0) {
+            printf("Render driver %s is not in this SDL build, probing the others.\n", name.c_str());
+        }
+        else {
+            SDL_Renderer *renderer = SDL_CreateRenderer(window, index, flags);
+            if (renderer != nullptr) {
+                return renderer;
+            }
+            printf("Failed to create render driver %s, probing the others. SDL Error: %s\n", name.c_str(), SDL_GetError());
+        }
+    }
+
+    // time every driver, keeping the fastest accelerated one and the software one apart
+    int nBest = -1, nSoftware = -1;
+    double dBest = 0.0, dSoftware = 0.0;
+    for (int i = 0; i < SDL_GetNumRenderDrivers(); ++i) {
+        SDL_RendererInfo info;
+        if (SDL_GetRenderDriverInfo(i, &info) != 0) {
+            continue;
+        }
+        double dTime = probeRenderDriver(window, i);
+        if (dTime < 0.0) {
+            printf("Render driver %s: unusable\n", info.name);
+            continue;
+        }
+        printf("Render driver %s: %.3f ms per frame\n", info.name, dTime);
+        if (info.flags & SDL_RENDERER_SOFTWARE) {
+            nSoftware = i;
+            dSoftware = dTime;
+        }
+        else if (nBest < 0 || dTime < dBest) {
+            nBest = i;
+            dBest = dTime;
+        }
+    }
+    // the GPU also takes composition and scaling off the CPU, which the probe does not
+    // measure, so software has to be clearly faster to win
+    if (nSoftware >= 0 && (nBest < 0 || dSoftware < dBest * dSoftwareMargin)) {
+        nBest = nSoftware;
+    }
+    if (nBest < 0) {
+        printf("No render driver works on this window.\n");
+        return nullptr;
+    }
+
+    SDL_Renderer *renderer = SDL_CreateRenderer(window, nBest, flags);
+    SDL_RendererInfo info;
+    if (renderer != nullptr && SDL_GetRendererInfo(renderer, &info) == 0) {
+        FILE *file = fopen(cacheFile.c_str(), "w");
+        if (file != nullptr) {
+            fprintf(file, "driver %s\n", info.name);
+            fclose(file);
+        }
+        printf("Using render driver %s.\n", info.name);
+    }
+    return renderer;
+}
@@ -0,0 +1,22 @@
+#ifndef RENDERERPROBE_H
+#define RENDERERPROBE_H
+
+#include <SDL.h>
+#include <string>
+
+// Milliseconds per frame, the median of a few batches, of a tiles-and-keyboard scene drawn with render
+// driver *index* on *window*, or a negative number if the driver does not work there
+double probeRenderDriver(SDL_Window *window, int index);
+
+/**
+ * Create the renderer for *window*, synced to the display if *vsync*.
+ *
+ * *driver* names the SDL render driver to use; otherwise the choice cached in
+ * *cacheFile* is used. If neither is given or the named driver fails, every
+ * driver is probed and the fastest one that works is used and cached, the
+ * software one only if it is clearly faster than every accelerated one. An empty
+ * *driver* or "auto" leaves the choice to the cache, "probe" probes again.
+ */
+SDL_Renderer *createBestRenderer(SDL_Window *window, bool vsync, const std::string &driver, const std::string &cacheFile);
+
+#endif // RENDERERPROBE_H
@@ -0,0 +1,47 @@
+#include "renderscale.h"
+#include <algorithm>
+
+// frames judged at a time
+const size_t nScaleWindow = 30;
+// the slowest tenth of the window is what has to fit the budget
+const double dScalePercentile = 0.9;
+const double dScaleStep = 0.125;
+// stepping up must be predicted to stay this far under budget, so the scale does not bounce
+const double dScaleHeadroom = 0.8;
+
+RenderScale::RenderScale(double dBudget, double dMinScale /*= 0.5*/) {
+    mBudget = dBudget;
+    mMinScale = dMinScale;
+    mScale = 1.0;
+    mTimes.reserve(nScaleWindow);
+}
+
+bool RenderScale::update(double dFrameTime) {
+    mTimes.push_back(dFrameTime);
+    if (mTimes.size() < nScaleWindow) {
+        return false;
+    }
+
+    std::vector<double>::iterator slow = mTimes.begin() + (size_t)(dScalePercentile * (nScaleWindow - 1));
+    std::nth_element(mTimes.begin(), slow, mTimes.end());
+    double dSlow = *slow;
+    mTimes.clear();
+
+    double dPrevious = mScale;
+    if (dSlow > mBudget) {
+        mScale = std::max(mScale - dScaleStep, mMinScale);
+    }
+    else if (mScale < 1.0) {
+        // the playfield's cost goes with its area, so predict the next step up from that
+        double dNext = std::min(mScale + dScaleStep, 1.0);
+        double dGrowth = (dNext * dNext) / (mScale * mScale);
+        if (dSlow * dGrowth < dScaleHeadroom * mBudget) {
+            mScale = dNext;
+        }
+    }
+    return mScale != dPrevious;
+}
+
+double RenderScale::scale() const {
+    return mScale;
+}
@@ -0,0 +1,31 @@
+#ifndef RENDERSCALE_H
+#define RENDERSCALE_H
+
+#include <vector>
+
+/**
+ * Picks the resolution the playfield is drawn at, from recent frame times.
+ *
+ * When the slowest of the recent frames run over the budget the scale steps
+ * down; when even a step up would leave headroom, it steps back up. After
+ * every change the window of frames starts over, so each decision is made on
+ * frames drawn at the current scale.
+ */
+class RenderScale {
+    public:
+        // *dBudget* in seconds per frame; the scale stays within [*dMinScale*, 1]
+        RenderScale(double dBudget, double dMinScale = 0.5);
+
+        // Record a frame that took *dFrameTime* seconds; true if the scale changed
+        bool update(double dFrameTime);
+
+        double scale() const;
+
+    private:
+        double mBudget;
+        double mMinScale;
+        double mScale;
+        std::vector<double> mTimes;
+};
+
+#endif // RENDERSCALE_H
@@ -1,4 +1,7 @@
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
 #include "olcNoiseMaker.h"
 #include "synthesizer.h"
 
@@ -44,7 +47,8 @@ namespace synth {
     double sEnvelopeADSR::getAmplitude(double dTime, double dTriggeredOn, double dTriggeredOff) {
         double dAmplitude = 0.0;
 
-        if (dTriggeredOn > dTriggeredOff) {
+        // a release scheduled ahead has not begun yet, so the note is still on
+        if (dTriggeredOn > dTriggeredOff || dTime < dTriggeredOff) {
             double dLifeTime = dTime - dTriggeredOn;
             if (dLifeTime >= 0 && dLifeTime <= dAttackTime) {
                 dAmplitude = (dLifeTime / dAttackTime) * dStartAmplitude;
@@ -91,13 +95,18 @@ namespace synth {
         env.dReleaseTime = 1.0;
     }
     double instrBell::sound(const note& n, double dTime) {
-        double dOutput = env.getAmplitude(dTime, n.dTimeOn, n.dTimeOff) * (
+        return env.getAmplitude(dTime, n.dTimeOn, n.dTimeOff) * waveform(n, dTime);
+    }
+    double instrBell::waveform(const note& n, double dTime) {
+        double dOutput =
             + 1.0 * osc(n.getFreq() * 2.0, dTime, SINE_WAVE, 5.0, 0.001)
             + 0.5 * osc(n.getFreq() * 3.0, dTime, SINE_WAVE)
-            + 0.25 * osc(n.getFreq() * 4.0, dTime, SINE_WAVE)
-        );
+            + 0.25 * osc(n.getFreq() * 4.0, dTime, SINE_WAVE);
         return dOutput / 1.75;
     }
+    std::string instrBell::name() const {
+        return "bell";
+    }
 
     instrHarmonica::instrHarmonica() {
         env.dAttackTime = 0.05;
@@ -107,12 +116,163 @@ namespace synth {
         env.dReleaseTime = 0.1;
     }
     double instrHarmonica::sound(const note& n, double dTime) {
-        double dOutput = env.getAmplitude(dTime, n.dTimeOn, n.dTimeOff) * (
+        return env.getAmplitude(dTime, n.dTimeOn, n.dTimeOff) * waveform(n, dTime);
+    }
+    double instrHarmonica::waveform(const note& n, double dTime) {
+        double dOutput =
             + 1.0 * osc(n.getFreq(), dTime, SQUARE_WAVE, 5.0, 0.001)
             + 0.5 * osc(n.getFreq() * 1.5, dTime, SQUARE_WAVE)
             + 0.25 * osc(n.getFreq() * 2.0, dTime, SQUARE_WAVE)
-            + 0.05 * osc(0, dTime, RANDOM_NOISE)
-        );
+            + 0.05 * osc(0, dTime, RANDOM_NOISE);
         return dOutput / 1.8;
     }
+    std::string instrHarmonica::name() const {
+        return "harmonica";
+    }
+
+    // bump whenever the cache layout or an instrument's waveform changes
+    const unsigned int nNoteCacheVersion = 1;
+    // shortest sustain loop, in seconds
+    const double dMinLoopTime = 0.25;
+    // crossfade at the loop seam, in seconds
+    const double dLoopFadeTime = 0.005;
+
+    instrCached::instrCached(instrument *source, unsigned int nSampleRate, int nKeys, const std::string &sCacheFile /*= ""*/)
+        : source(source), nSampleRate(nSampleRate) {
+        env = source->env;
+        if (sCacheFile.empty() || !load(sCacheFile, nKeys)) {
+            render(nKeys);
+            if (!sCacheFile.empty()) {
+                save(sCacheFile);
+            }
+        }
+    }
+    instrCached::~instrCached() {
+        delete source;
+    }
+
+    double instrCached::sound(const note& n, double dTime) {
+        return env.getAmplitude(dTime, n.dTimeOn, n.dTimeOff) * waveform(n, dTime);
+    }
+
+    // *dTime* is global time like for every other instrument; the tables start at the note's onset
+    double instrCached::waveform(const note& n, double dTime) {
+        double dLifeTime = dTime - n.dTimeOn;
+        if (n.id < 0 || n.id >= (int)tables.size() || dLifeTime < 0.0) {
+            return 0.0;
+        }
+
+        const sKeyTable &table = tables[n.id];
+        unsigned int nSize = table.samples.size();
+        unsigned int nLoopLength = nSize - table.nLoopStart;
+
+        double dPosition = dLifeTime * nSampleRate;
+        unsigned long long i = (unsigned long long)dPosition;
+        double dFraction = dPosition - (double)i;
+        unsigned long long j = i + 1;
+
+        // wrap both ends of the interpolation into the sustain loop
+        if (i >= nSize) {
+            i = table.nLoopStart + (i - table.nLoopStart) % nLoopLength;
+        }
+        if (j >= nSize) {
+            j = table.nLoopStart + (j - table.nLoopStart) % nLoopLength;
+        }
+        return table.samples[i] + (table.samples[j] - table.samples[i]) * dFraction;
+    }
+
+    std::string instrCached::name() const {
+        return source->name();
+    }
+
+    void instrCached::render(int nKeys) {
+        tables.assign(nKeys, sKeyTable());
+        double dTimeStep = 1.0 / (double)nSampleRate;
+
+        for (int k = 0; k < nKeys; ++k) {
+            note n(k, 0.0);
+            double dFreq = n.getFreq();
+
+            // the loop holds an even number of the key's periods, which also
+            // covers the harmonica's 1.5x partial
+            double dPeriods = 2.0 * ceil(dMinLoopTime * dFreq / 2.0);
+            unsigned int nLoopLength = (unsigned int)round(dPeriods / dFreq * nSampleRate);
+            unsigned int nHead = (unsigned int)ceil((env.dAttackTime + env.dDecayTime) * nSampleRate);
+            unsigned int nFade = std::min<unsigned int>((unsigned int)(dLoopFadeTime * nSampleRate), std::min(nHead, nLoopLength / 4));
+
+            sKeyTable &table = tables[k];
+            table.nLoopStart = nHead;
+            table.samples.resize(nHead + nLoopLength);
+            for (unsigned int i = 0; i < table.samples.size(); ++i) {
+                table.samples[i] = (float)source->waveform(n, i * dTimeStep);
+            }
+
+            // blend the end of the loop into the samples that lead up to its start,
+            // so wrapping around does not click
+            for (unsigned int i = 0; i < nFade; ++i) {
+                double dBlend = (double)(i + 1) / (double)(nFade + 1);
+                float &fTail = table.samples[nHead + nLoopLength - nFade + i];
+                fTail = (float)((1.0 - dBlend) * fTail + dBlend * table.samples[nHead - nFade + i]);
+            }
+        }
+    }
+
+    // Cache file layout: "PTNC", version, sample rate, key count, name length, name,
+    // then for every key its loop start, sample count and samples as floats
+    bool instrCached::load(const std::string &sCacheFile, int nKeys) {
+        FILE *file = fopen(sCacheFile.c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+
+        bool success = false;
+        char magic[4];
+        unsigned int header[4];
+        std::string sName = source->name();
+        if (fread(magic, 1, 4, file) == 4 && memcmp(magic, "PTNC", 4) == 0
+            && fread(header, sizeof(unsigned int), 4, file) == 4
+            && header[0] == nNoteCacheVersion && header[1] == nSampleRate
+            && header[2] == (unsigned int)nKeys && header[3] == sName.size()) {
+            std::string sStoredName(header[3], '\0');
+            success = fread(&sStoredName[0], 1, sStoredName.size(), file) == sStoredName.size() && sStoredName == sName;
+
+            tables.assign(nKeys, sKeyTable());
+            for (int k = 0; success && k < nKeys; ++k) {
+                unsigned int info[2];
+                success = fread(info, sizeof(unsigned int), 2, file) == 2 && info[0] < info[1];
+                if (success) {
+                    tables[k].nLoopStart = info[0];
+                    tables[k].samples.resize(info[1]);
+                    success = fread(tables[k].samples.data(), sizeof(float), info[1], file) == info[1];
+                }
+            }
+        }
+        fclose(file);
+
+        if (!success) {
+            printf("Note cache %s is stale or damaged, rendering it again.\n", sCacheFile.c_str());
+            tables.clear();
+        }
+        return success;
+    }
+
+    void instrCached::save(const std::string &sCacheFile) const {
+        FILE *file = fopen(sCacheFile.c_str(), "wb");
+        if (file == nullptr) {
+            printf("Failed to write note cache %s.\n", sCacheFile.c_str());
+            return;
+        }
+
+        std::string sName = source->name();
+        unsigned int header[4] = {nNoteCacheVersion, nSampleRate, (unsigned int)tables.size(), (unsigned int)sName.size()};
+        fwrite("PTNC", 1, 4, file);
+        fwrite(header, sizeof(unsigned int), 4, file);
+        fwrite(sName.data(), 1, sName.size(), file);
+        for (const auto &table: tables) {
+            unsigned int info[2] = {table.nLoopStart, (unsigned int)table.samples.size()};
+            fwrite(info, sizeof(unsigned int), 2, file);
+            fwrite(table.samples.data(), sizeof(float), table.samples.size(), file);
+        }
+        fclose(file);
+    }
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define SYNTHESIZER_H
 
 #include <cmath>
+#include <string>
+#include <vector>
 
 namespace synth {    
     const double dOctaveBaseFrequency = 130.813; // C3
@@ -23,7 +25,7 @@ namespace synth {
         double dTimeOff = 0.0;
         double dInitAmplitude = 0.0;
         double getFreq() const;
-        note(int id = 0, int dTimeOn = 0.0): id(id), dTimeOn(dTimeOn) {}
+        note(int id = 0, double dTimeOn = 0.0): id(id), dTimeOn(dTimeOn) {}
     };
 
     inline double w(double dHertz);
@@ -41,16 +43,56 @@ namespace synth {
     struct instrument {
         sEnvelopeADSR env;
         virtual double sound(const note& n, double dTime) = 0;
+        // the note's oscillators without the envelope applied
+        virtual double waveform(const note& n, double dTime) = 0;
+        // identifies the waveform, used to key the on-disk note cache
+        virtual std::string name() const = 0;
+        virtual ~instrument() {}
     };
 
     struct instrBell : public instrument {
         instrBell();
         double sound(const note& n, double dTime);
+        double waveform(const note& n, double dTime);
+        std::string name() const;
     };    
 
     struct instrHarmonica : public instrument {
         instrHarmonica();
         double sound(const note& n, double dTime);
+        double waveform(const note& n, double dTime);
+        std::string name() const;
+    };
+
+    /**
+     * Plays another instrument's notes back from pre-rendered tables.
+     *
+     * Each key's waveform is rendered once over its attack and decay, followed by
+     * a sustain loop, so a playing note costs a table read and the live envelope.
+     * The tables are loaded from *sCacheFile* when it matches the instrument and
+     * sample rate, otherwise they are rendered and written back to it.
+     */
+    struct instrCached : public instrument {
+        // takes ownership of *source*
+        instrCached(instrument *source, unsigned int nSampleRate, int nKeys, const std::string &sCacheFile = "");
+        ~instrCached();
+        double sound(const note& n, double dTime);
+        double waveform(const note& n, double dTime);
+        std::string name() const;
+
+    private:
+        struct sKeyTable {
+            std::vector<float> samples;
+            unsigned int nLoopStart = 0;
+        };
+
+        instrument *source;
+        unsigned int nSampleRate;
+        std::vector<sKeyTable> tables;
+
+        void render(int nKeys);
+        bool load(const std::string &sCacheFile, int nKeys);
+        void save(const std::string &sCacheFile) const;
     };
 
 }
@@ -0,0 +1,179 @@
+#include "termkeys.h"
+#ifndef _WIN32
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <cerrno>
+#include <algorithm>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/input.h>
+#endif
+
+TermKeys::TermKeys(const std::string &chars, const std::vector<int> &codes, int nRepeatDelayMs /*= REPEAT_DELAY_MS*/, int nRepeatGapMs /*= REPEAT_GAP_MS*/)
+    : mPressed(chars.size(), false), mReleaseAt(chars.size()), mRepeatDelay(nRepeatDelayMs), mRepeatGap(nRepeatGapMs), mEvdev(-1), mRaw(false) {
+    std::fill(mKeys, mKeys + 256, -1);
+    for (size_t i = 0; i < chars.size(); ++i) {
+        unsigned char c = chars[i];
+        mKeys[c] = (int)i;
+        mKeys[toupper(c)] = (int)i;
+    }
+    int nMaxCode = codes.empty() ? -1 : *std::max_element(codes.begin(), codes.end());
+    mCodes.assign(nMaxCode + 1, -1);
+    for (size_t i = 0; i < codes.size(); ++i) {
+        mCodes[codes[i]] = (int)i;
+    }
+}
+
+TermKeys::~TermKeys() {
+    close();
+}
+
+bool TermKeys::open(const std::string &evdevPath /*= ""*/) {
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &mSaved) != 0) {
+        fprintf(stderr, "Failed to read the terminal. Run the synth in a terminal.\n");
+        return false;
+    }
+
+    // every byte as it is typed, not echoed, with Ctrl-C read as a key rather than a signal
+    termios raw = mSaved;
+    raw.c_lflag &= ~(ICANON | ECHO | ISIG | IEXTEN);
+    raw.c_iflag &= ~(IXON | ICRNL);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) != 0) {
+        fprintf(stderr, "Failed to put the terminal in raw mode. Error: %s\n", strerror(errno));
+        return false;
+    }
+    mRaw = true;
+
+    if (!evdevPath.empty()) {
+#ifdef __linux__
+        mEvdev = ::open(evdevPath.c_str(), O_RDONLY | O_NONBLOCK);
+        if (mEvdev < 0) {
+            fprintf(stderr, "Failed to open %s, releases will be guessed from the terminal. Error: %s\n", evdevPath.c_str(), strerror(errno));
+        }
+#else
+        fprintf(stderr, "evdev is only read on Linux, releases will be guessed from the terminal.\n");
+#endif
+    }
+    return true;
+}
+
+void TermKeys::close() {
+    if (mEvdev >= 0) {
+        ::close(mEvdev);
+        mEvdev = -1;
+    }
+    if (mRaw) {
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &mSaved);
+        mRaw = false;
+    }
+}
+
+bool TermKeys::pressed(int key) const {
+    return mPressed[key];
+}
+
+void TermKeys::typed(int key, Clock::time_point now, std::vector<KeyEvent> &events) {
+    // a held key's repeats only put its release off
+    if (mPressed[key]) {
+        mReleaseAt[key] = now + mRepeatGap;
+        return;
+    }
+    mPressed[key] = true;
+    mReleaseAt[key] = now + mRepeatDelay;
+    events.push_back(KeyEvent{key, true});
+}
+
+bool TermKeys::readEvdev(std::vector<KeyEvent> &events) {
+#ifdef __linux__
+    input_event inputs[64];
+    ssize_t nRead;
+    while ((nRead = read(mEvdev, inputs, sizeof(inputs))) > 0) {
+        for (size_t i = 0; i < nRead / sizeof(input_event); ++i) {
+            const input_event &input = inputs[i];
+            // 1 is a press and 0 a release; 2, the autorepeat, changes nothing
+            if (input.type != EV_KEY || input.value == 2 || input.code >= mCodes.size()) {
+                continue;
+            }
+            int key = mCodes[input.code];
+            bool bDown = input.value == 1;
+            if (key >= 0 && mPressed[key] != bDown) {
+                mPressed[key] = bDown;
+                events.push_back(KeyEvent{key, bDown});
+            }
+        }
+    }
+    return nRead < 0 && errno == EAGAIN;
+#else
+    return false;
+#endif
+}
+
+bool TermKeys::wait(std::vector<KeyEvent> &events, int nTimeoutMs /*= -1*/) {
+    // wake in time to release the keys whose repeats have stopped
+    Clock::time_point now = Clock::now();
+    if (mEvdev < 0) {
+        for (size_t i = 0; i < mPressed.size(); ++i) {
+            if (mPressed[i]) {
+                auto nLeft = std::chrono::duration_cast<std::chrono::milliseconds>(mReleaseAt[i] - now).count() + 1;
+                int nDue = nLeft > 0 ? (int)nLeft : 0;
+                nTimeoutMs = nTimeoutMs < 0 ? nDue : std::min(nTimeoutMs, nDue);
+            }
+        }
+    }
+
+    pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {mEvdev, POLLIN, 0}};
+    if (poll(fds, mEvdev >= 0 ? 2 : 1, nTimeoutMs) < 0 && errno != EINTR) {
+        fprintf(stderr, "Failed to wait for keys. Error: %s\n", strerror(errno));
+        return false;
+    }
+    now = Clock::now();
+
+    if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+        unsigned char typedBytes[64];
+        ssize_t nRead = read(STDIN_FILENO, typedBytes, sizeof(typedBytes));
+        // the terminal went away
+        if (nRead <= 0) {
+            return false;
+        }
+        for (ssize_t i = 0; i < nRead; ++i) {
+            // Ctrl-C, Ctrl-D or q
+            if (typedBytes[i] == 3 || typedBytes[i] == 4 || typedBytes[i] == 'q') {
+                return false;
+            }
+            // with evdev the characters are only echoes of keys it already reported
+            int key = mKeys[typedBytes[i]];
+            if (key >= 0 && mEvdev < 0) {
+                typed(key, now, events);
+            }
+        }
+    }
+
+    if (mEvdev >= 0 && (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) && !readEvdev(events)) {
+        // fall back to the terminal, and release what evdev can no longer report
+        fprintf(stderr, "Lost the evdev device, releases will be guessed from the terminal.\n");
+        ::close(mEvdev);
+        mEvdev = -1;
+        for (size_t i = 0; i < mPressed.size(); ++i) {
+            if (mPressed[i]) {
+                mPressed[i] = false;
+                events.push_back(KeyEvent{(int)i, false});
+            }
+        }
+    }
+
+    if (mEvdev < 0) {
+        for (size_t i = 0; i < mPressed.size(); ++i) {
+            if (mPressed[i] && now >= mReleaseAt[i]) {
+                mPressed[i] = false;
+                events.push_back(KeyEvent{(int)i, false});
+            }
+        }
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,79 @@
+#ifndef TERMKEYS_H
+#define TERMKEYS_H
+
+#include <string>
+#include <vector>
+
+// A key of the synth going down or up
+struct KeyEvent {
+    int key;
+    bool bDown;
+};
+
+#ifndef _WIN32
+#include <termios.h>
+#include <chrono>
+
+/**
+ * Reads the synth's keys from the terminal, so it can be played over a plain
+ * TTY or SSH without a window.
+ *
+ * The terminal is put in raw mode and waited on with poll(), so nothing runs
+ * between key presses. A terminal sends characters but never releases, so a
+ * key counts as held while the terminal's autorepeat keeps sending it and is
+ * released once it falls silent. A readable evdev keyboard reports real
+ * releases, and is used for the keys instead when one is given.
+ */
+class TermKeys {
+    public:
+        // the default ms a tapped key sounds, which must outlast the terminal's autorepeat
+        // delay (660 ms on Xorg, 500-600 ms on most consoles)
+        static const int REPEAT_DELAY_MS = 700;
+        // the default ms a held key lasts after its last repeat, which must outlast the repeat interval
+        static const int REPEAT_GAP_MS = 250;
+
+        // Key i is played by the character *chars*[i], or on evdev by the key code *codes*[i];
+        // *nRepeatDelayMs* and *nRepeatGapMs* should exceed the terminal's autorepeat delay and interval
+        TermKeys(const std::string &chars, const std::vector<int> &codes, int nRepeatDelayMs = REPEAT_DELAY_MS, int nRepeatGapMs = REPEAT_GAP_MS);
+        ~TermKeys();
+
+        // Put the terminal in raw mode, and read the evdev device *evdevPath* too if one is named
+        bool open(const std::string &evdevPath = "");
+
+        // Restore the terminal and close the evdev device
+        void close();
+
+        // Wait up to *nTimeoutMs* ms, or until the keys change if negative, appending
+        // the presses and releases to *events*; false once the user asked to quit
+        bool wait(std::vector<KeyEvent> &events, int nTimeoutMs = -1);
+
+        // Whether key *key* is held
+        bool pressed(int key) const;
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        // the key each byte plays, or -1
+        int mKeys[256];
+        // the key each evdev code plays, or -1
+        std::vector<int> mCodes;
+        std::vector<bool> mPressed;
+        // when each held key counts as released if the terminal sends nothing more
+        std::vector<Clock::time_point> mReleaseAt;
+
+        std::chrono::milliseconds mRepeatDelay;
+        std::chrono::milliseconds mRepeatGap;
+
+        int mEvdev;
+        bool mRaw;
+        termios mSaved;
+
+        // Count a character for *key* typed at *now*
+        void typed(int key, Clock::time_point now, std::vector<KeyEvent> &events);
+
+        // Read the evdev device's pending events; false if it failed
+        bool readEvdev(std::vector<KeyEvent> &events);
+};
+#endif
+
+#endif // TERMKEYS_H
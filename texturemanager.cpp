@@ -0,0 +1,169 @@
+#include "texturemanager.h"
+#include <cstdio>
+
+TextureManager::Handle::Handle() {
+    mOwner = nullptr;
+    mEntry = nullptr;
+}
+
+TextureManager::Handle::Handle(TextureManager *owner, Entry *entry) {
+    mOwner = owner;
+    mEntry = entry;
+}
+
+TextureManager::Handle::~Handle() {
+    reset();
+}
+
+TextureManager::Handle::Handle(Handle &&other) {
+    mOwner = other.mOwner;
+    mEntry = other.mEntry;
+    other.mOwner = nullptr;
+    other.mEntry = nullptr;
+}
+
+TextureManager::Handle &TextureManager::Handle::operator=(Handle &&other) {
+    if (this != &other) {
+        reset();
+        mOwner = other.mOwner;
+        mEntry = other.mEntry;
+        other.mOwner = nullptr;
+        other.mEntry = nullptr;
+    }
+    return *this;
+}
+
+const LTexture *TextureManager::Handle::get() const {
+    if (mEntry == nullptr || mEntry->nBytes == 0) {
+        return nullptr;
+    }
+    return &mEntry->texture;
+}
+
+const LTexture *TextureManager::Handle::operator->() const {
+    return get();
+}
+
+TextureManager::Handle::operator bool() const {
+    return get() != nullptr;
+}
+
+void TextureManager::Handle::reset() {
+    if (mEntry != nullptr) {
+        mOwner->release(mEntry);
+        mOwner = nullptr;
+        mEntry = nullptr;
+    }
+}
+
+TextureManager::TextureManager(SDL_Renderer *renderer, size_t nBudgetBytes) {
+    mRenderer = renderer;
+    mBudget = nBudgetBytes;
+    mBytes = 0;
+    mClock = 0;
+}
+
+TextureManager::~TextureManager() {
+    for (auto &item: mEntries) {
+        if (item.second.nRefs != 0) {
+            printf("Texture %s is still held while its manager is destroyed.\n", item.first.c_str());
+        }
+    }
+}
+
+// The cache key of *path* loaded with *colorKey*
+static std::string textureKey(const std::string &path, const SDL_Color *colorKey) {
+    std::string key = path;
+    if (colorKey != nullptr) {
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), "#%02X%02X%02X", colorKey->r, colorKey->g, colorKey->b);
+        key += suffix;
+    }
+    return key;
+}
+
+TextureManager::Handle TextureManager::acquire(const std::string &path, const SDL_Color *colorKey /*= nullptr*/) {
+    bool bCreated;
+    Entry &found = entry(textureKey(path, colorKey), bCreated);
+    if (bCreated) {
+        found.texture.loadFromFile(path, mRenderer, colorKey);
+    }
+    return use(found, bCreated);
+}
+
+TextureManager::Handle TextureManager::acquire(const std::string &path, SDL_Surface *decoded, const SDL_Color *colorKey /*= nullptr*/) {
+    bool bCreated;
+    Entry &found = entry(textureKey(path, colorKey), bCreated);
+    if (bCreated) {
+        found.texture.loadFromSurface(decoded, mRenderer, colorKey);
+    }
+    return use(found, bCreated);
+}
+
+TextureManager::Handle TextureManager::acquire(const AssetPack &pack, const std::string &name) {
+    // cached apart from the file of the same name, which the pack may be older than
+    bool bCreated;
+    Entry &found = entry("pack:" + name, bCreated);
+    if (bCreated) {
+        found.texture.loadFromPack(pack, name, mRenderer);
+    }
+    return use(found, bCreated);
+}
+
+TextureManager::Entry &TextureManager::entry(const std::string &key, bool &bCreated) {
+    auto found = mEntries.find(key);
+    bCreated = found == mEntries.end();
+    if (bCreated) {
+        Entry &created = mEntries[key];
+        created.key = key;
+        created.nRefs = 0;
+        created.nBytes = 0;
+        return created;
+    }
+    return found->second;
+}
+
+TextureManager::Handle TextureManager::use(Entry &entry, bool bCreated) {
+    // failed loads are cached too, at no cost, so a missing file is not retried every frame
+    if (bCreated) {
+        entry.nBytes = (size_t)entry.texture.getWidth() * entry.texture.getHeight() * 4;
+        mBytes += entry.nBytes;
+    }
+    ++entry.nRefs;
+    entry.nLastUse = ++mClock;
+    // a new texture may have pushed the total over the budget
+    evict();
+    return Handle(this, &entry);
+}
+
+void TextureManager::release(Entry *entry) {
+    if (--entry->nRefs == 0) {
+        evict();
+    }
+}
+
+void TextureManager::setBudget(size_t nBudgetBytes) {
+    mBudget = nBudgetBytes;
+    evict();
+}
+
+size_t TextureManager::bytes() const {
+    return mBytes;
+}
+
+void TextureManager::evict() {
+    while (mBytes > mBudget) {
+        // the unheld texture used longest ago; a scan, as only a handful are ever cached
+        auto oldest = mEntries.end();
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+            if (it->second.nRefs == 0 && (oldest == mEntries.end() || it->second.nLastUse < oldest->second.nLastUse)) {
+                oldest = it;
+            }
+        }
+        if (oldest == mEntries.end()) {
+            return;
+        }
+        mBytes -= oldest->second.nBytes;
+        mEntries.erase(oldest);
+    }
+}
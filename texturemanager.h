@@ -0,0 +1,101 @@
+#ifndef TEXTUREMANAGER_H
+#define TEXTUREMANAGER_H
+
+#include <SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "assetpack.h"
+#include "ltexture.h"
+
+/**
+ * Loads textures by path, at most once each, and keeps their memory under a budget.
+ *
+ * acquire() hands out a Handle that keeps its texture alive; a path that is
+ * already loaded just gains a reference. Every acquire stamps the texture as
+ * used, and textures nobody holds stay cached until the estimated bytes of
+ * everything loaded exceed the budget. Then the unheld texture with the oldest
+ * stamp, the least recently used, is freed first. Textures in use are never
+ * evicted, so the budget can be overrun while they are held.
+ */
+class TextureManager {
+    private:
+        struct Entry;
+
+    public:
+        // A reference to a loaded texture; moves but never copies
+        class Handle {
+            public:
+                Handle();
+                ~Handle();
+                Handle(const Handle&) = delete;
+                Handle &operator=(const Handle&) = delete;
+                Handle(Handle &&other);
+                Handle &operator=(Handle &&other);
+
+                // The texture, or nullptr if the handle is empty or loading failed
+                const LTexture *get() const;
+                const LTexture *operator->() const;
+                explicit operator bool() const;
+
+                // Drop the reference early
+                void reset();
+
+            private:
+                friend class TextureManager;
+                Handle(TextureManager *owner, Entry *entry);
+
+                TextureManager *mOwner;
+                Entry *mEntry;
+        };
+
+        TextureManager(SDL_Renderer *renderer, size_t nBudgetBytes);
+        // every handle must be gone by now
+        ~TextureManager();
+
+        // The texture at *path*, loading it unless it is already cached; pixels
+        // matching *colorKey* are transparent, and each key is cached separately
+        Handle acquire(const std::string &path, const SDL_Color *colorKey = nullptr);
+
+        // The same, but a texture not cached yet is created from *decoded*, the image at
+        // *path* already decoded elsewhere, which stays owned by the caller
+        Handle acquire(const std::string &path, SDL_Surface *decoded, const SDL_Color *colorKey = nullptr);
+
+        // The image stored under *name* in *pack*, uploaded from the mapped file unless cached
+        Handle acquire(const AssetPack &pack, const std::string &name);
+
+        // Change the budget, evicting at once if it shrank
+        void setBudget(size_t nBudgetBytes);
+
+        // Estimated bytes of every texture loaded, held or cached
+        size_t bytes() const;
+
+    private:
+        struct Entry {
+            std::string key;
+            LTexture texture;
+            int nRefs;
+            size_t nBytes;
+            // the manager's clock at the last acquire
+            uint64_t nLastUse;
+        };
+
+        SDL_Renderer *mRenderer;
+        size_t mBudget;
+        size_t mBytes;
+        // counts acquires, stamping each entry with when it was last used
+        uint64_t mClock;
+        // node based, so the entries handles point at never move
+        std::unordered_map<std::string, Entry> mEntries;
+
+        // The entry cached under *key*, or a new empty one that the caller loads
+        Entry &entry(const std::string &key, bool &bCreated);
+        // Account for a loaded *entry*, stamp it and hand out a reference to it
+        Handle use(Entry &entry, bool bCreated);
+
+        void release(Entry *entry);
+        void evict();
+};
+
+#endif // TEXTUREMANAGER_H
@@ -0,0 +1,74 @@
+#include "tilebatch.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+TileBatch::TileBatch(const std::vector<SDL_Color> &palette) : mPalette(palette), mRects(palette.size()) {}
+
+void TileBatch::add(const SDL_Rect &rect, int color) {
+    mRects[color].push_back(rect);
+}
+
+int TileBatch::flush(SDL_Renderer *renderer) {
+    int nDrawCalls = 0;
+    for (size_t i = 0; i < mRects.size(); ++i) {
+        if (mRects[i].empty()) {
+            continue;
+        }
+        const SDL_Color &color = mPalette[i];
+        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+        SDL_RenderFillRects(renderer, mRects[i].data(), (int)mRects[i].size());
+        mRects[i].clear();
+        ++nDrawCalls;
+    }
+    return nDrawCalls;
+}
+
+void fillRow(Uint32 *row, int n, Uint32 value) {
+    int i = 0;
+#ifdef __SSE2__
+    // four pixels per store; unaligned stores cost nothing extra on current CPUs
+    __m128i quad = _mm_set1_epi32((int)value);
+    for (; i + 16 <= n; i += 16) {
+        _mm_storeu_si128((__m128i*)(row + i), quad);
+        _mm_storeu_si128((__m128i*)(row + i + 4), quad);
+        _mm_storeu_si128((__m128i*)(row + i + 8), quad);
+        _mm_storeu_si128((__m128i*)(row + i + 12), quad);
+    }
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_si128((__m128i*)(row + i), quad);
+    }
+#endif
+    for (; i < n; ++i) {
+        row[i] = value;
+    }
+}
+
+int TileBatch::rasterize(Uint32 *pixels, int pitch, int width, int height, const SDL_PixelFormat *format, double scaleX /*= 1.0*/, double scaleY /*= 1.0*/) {
+    SDL_Rect bounds{0, 0, width, height};
+    int nFilled = 0;
+    for (size_t i = 0; i < mRects.size(); ++i) {
+        const SDL_Color &color = mPalette[i];
+        Uint32 value = SDL_MapRGBA(format, color.r, color.g, color.b, 0xFF);
+        for (SDL_Rect rect: mRects[i]) {
+            // scale the edges rather than the size, so neighbouring tiles still meet
+            if (scaleX != 1.0 || scaleY != 1.0) {
+                int x0 = (int)(rect.x * scaleX), y0 = (int)(rect.y * scaleY);
+                int x1 = (int)((rect.x + rect.w) * scaleX), y1 = (int)((rect.y + rect.h) * scaleY);
+                rect = {x0, y0, x1 - x0, y1 - y0};
+            }
+            // tiles are axis-aligned, so after clipping each one is a run of whole row spans
+            SDL_Rect clipped;
+            if (!SDL_IntersectRect(&rect, &bounds, &clipped)) {
+                continue;
+            }
+            Uint8 *row = (Uint8*)pixels + clipped.y * pitch;
+            for (int y = 0; y < clipped.h; ++y, row += pitch) {
+                fillRow((Uint32*)row + clipped.x, clipped.w, value);
+            }
+            ++nFilled;
+        }
+        mRects[i].clear();
+    }
+    return nFilled;
+}
@@ -0,0 +1,36 @@
+#ifndef TILEBATCH_H
+#define TILEBATCH_H
+
+#include <SDL.h>
+#include <vector>
+
+/**
+ * Collects the frame's tile rects into one array per color and draws each array
+ * with a single SDL_RenderFillRects call, instead of one renderer call per tile.
+ *
+ * The arrays keep their capacity between frames, so a warmed-up batch does not allocate.
+ */
+class TileBatch {
+    public:
+        explicit TileBatch(const std::vector<SDL_Color> &palette);
+
+        // Queue *rect* to be filled with palette entry *color*
+        void add(const SDL_Rect &rect, int color);
+
+        // Draw and empty the queued rects; returns the number of draw calls made
+        int flush(SDL_Renderer *renderer);
+
+        // Fill the queued rects, scaled by *scaleX* across and *scaleY* down, straight into
+        // a *width* x *height* buffer of 32-bit *format* pixels and empty them; colors are
+        // written opaque, not blended. Returns the number of rects filled.
+        int rasterize(Uint32 *pixels, int pitch, int width, int height, const SDL_PixelFormat *format, double scaleX = 1.0, double scaleY = 1.0);
+
+    private:
+        std::vector<SDL_Color> mPalette;
+        std::vector<std::vector<SDL_Rect>> mRects;
+};
+
+// Set *n* 32-bit pixels from *row* on to *value*
+void fillRow(Uint32 *row, int n, Uint32 value);
+
+#endif // TILEBATCH_H
@@ -0,0 +1,102 @@
+#include "tilepool.h"
+#include <algorithm>
+
+// the ring index wraps with a mask
+static_assert((TilePool::CAPACITY & (TilePool::CAPACITY - 1)) == 0, "tile pool capacity must be a power of two");
+
+TilePool::TilePool(double dSpeed, int nLeadHeight)
+    : mSpeed(dSpeed), mLeadHeight(nLeadHeight), mHead(0), mCount(0),
+      mTimeOn(CAPACITY), mTimeOff(CAPACITY), mY(CAPACITY), mHeight(CAPACITY), mPrevY(CAPACITY), mPrevHeight(CAPACITY), mLane(CAPACITY), mColor(CAPACITY) {}
+
+int TilePool::open(int lane, int color, double dTime) {
+    if (mCount == CAPACITY) {
+        return -1;
+    }
+    int i = (mHead + mCount) & (CAPACITY - 1);
+    mTimeOn[i] = dTime;
+    mTimeOff[i] = dTime - 1.0;
+    mY[i] = mHeight[i] = mPrevY[i] = mPrevHeight[i] = 0;
+    mLane[i] = (uint8_t)lane;
+    mColor[i] = (uint8_t)color;
+    ++mCount;
+    return i;
+}
+
+void TilePool::close(int handle, double dTime) {
+    if (handle >= 0) {
+        mTimeOff[handle] = std::max(dTime, mTimeOn[handle]);
+    }
+}
+
+// Straight-line arithmetic with selects only, so the compiler can vectorise it
+void TilePool::updateRange(int begin, int end, double dTime, int nHeight) {
+    for (int i = begin; i < end; ++i) {
+        double dBottom = mLeadHeight + (dTime - mTimeOn[i]) * mSpeed;
+        double dTop = mTimeOff[i] < mTimeOn[i] ? 0.0 : (dTime - mTimeOff[i]) * mSpeed;
+        dBottom = dTime < mTimeOn[i] ? 0.0 : std::min(dBottom, (double)nHeight);
+        dTop = std::max(dTop, 0.0);
+        mPrevY[i] = mY[i];
+        mPrevHeight[i] = mHeight[i];
+        mY[i] = (int)dTop;
+        mHeight[i] = std::max((int)dBottom - (int)dTop, 0);
+    }
+}
+
+void TilePool::update(double dTime, int nHeight) {
+    int nEnd = mHead + mCount;
+    updateRange(mHead, nEnd < CAPACITY ? nEnd : CAPACITY, dTime, nHeight);
+    if (nEnd > CAPACITY) {
+        updateRange(0, nEnd - CAPACITY, dTime, nHeight);
+    }
+
+    // a closed tile whose trailing edge has passed the bottom is gone
+    int nRetired = 0;
+    while (nRetired < mCount) {
+        int i = (mHead + nRetired) & (CAPACITY - 1);
+        if (mTimeOff[i] < mTimeOn[i] || (dTime - mTimeOff[i]) * mSpeed < nHeight) {
+            break;
+        }
+        ++nRetired;
+    }
+    mHead = (mHead + nRetired) & (CAPACITY - 1);
+    mCount -= nRetired;
+}
+
+void TilePool::draw(TileBatch &batch, const SDL_Rect *lanes, double alpha /*= 1.0*/) const {
+    for (int k = 0; k < mCount; ++k) {
+        int i = (mHead + k) & (CAPACITY - 1);
+        int y = (int)(mPrevY[i] + alpha * (mY[i] - mPrevY[i]) + 0.5);
+        int h = (int)(mPrevHeight[i] + alpha * (mHeight[i] - mPrevHeight[i]) + 0.5);
+        if (h > 0) {
+            const SDL_Rect &lane = lanes[mLane[i]];
+            batch.add({lane.x, y, lane.w, h}, mColor[i]);
+        }
+    }
+}
+
+int TilePool::size() const {
+    return mCount;
+}
+
+// Copy the ring slots [begin, begin + count) of *from* into *to*
+template<class T>
+static void copyRing(const std::vector<T> &from, std::vector<T> &to, int begin, int count) {
+    int nFirst = count < TilePool::CAPACITY - begin ? count : TilePool::CAPACITY - begin;
+    std::copy(from.begin() + begin, from.begin() + begin + nFirst, to.begin() + begin);
+    std::copy(from.begin(), from.begin() + (count - nFirst), to.begin());
+}
+
+void TilePool::copyTo(TilePool &other) const {
+    other.mSpeed = mSpeed;
+    other.mLeadHeight = mLeadHeight;
+    other.mHead = mHead;
+    other.mCount = mCount;
+    copyRing(mTimeOn, other.mTimeOn, mHead, mCount);
+    copyRing(mTimeOff, other.mTimeOff, mHead, mCount);
+    copyRing(mY, other.mY, mHead, mCount);
+    copyRing(mHeight, other.mHeight, mHead, mCount);
+    copyRing(mPrevY, other.mPrevY, mHead, mCount);
+    copyRing(mPrevHeight, other.mPrevHeight, mHead, mCount);
+    copyRing(mLane, other.mLane, mHead, mCount);
+    copyRing(mColor, other.mColor, mHead, mCount);
+}
@@ -0,0 +1,70 @@
+#ifndef TILEPOOL_H
+#define TILEPOOL_H
+
+#include <SDL.h>
+#include <vector>
+#include <cstdint>
+#include "tilebatch.h"
+
+/**
+ * The falling tiles, kept in a fixed-capacity ring as parallel arrays.
+ *
+ * Each tile is opened by a key press and closed by its release; its y and height
+ * are recomputed for the whole pool in one loop per simulation step, and tiles
+ * that have fallen out of view are retired from the front in bulk. The previous
+ * step's geometry is kept so drawing can interpolate between steps. Nothing is
+ * allocated after construction.
+ *
+ * At most CAPACITY tiles can be alive at once; further presses get no tile until
+ * old ones retire. Tiles retire in the order they were opened, so a key held for
+ * a long time keeps later, already finished tiles alive behind it.
+ */
+class TilePool {
+    public:
+        static const int CAPACITY = 16384;
+
+        // *dSpeed* in pixels per second; a tile's leading edge starts *nLeadHeight* pixels down
+        TilePool(double dSpeed, int nLeadHeight);
+
+        // Open a tile in *lane* drawn with palette entry *color*; returns a handle
+        // for close(), or -1 if the pool is full
+        int open(int lane, int color, double dTime);
+
+        // Stop the tile from growing; it falls away from *dTime* on
+        void close(int handle, double dTime);
+
+        // Place every tile at *dTime* in a playfield *nHeight* pixels tall and
+        // retire the ones that have left it
+        void update(double dTime, int nHeight);
+
+        // Queue the visible tiles, *alpha* of the way from the previous update to
+        // the latest one, using *lanes* for their x and width
+        void draw(TileBatch &batch, const SDL_Rect *lanes, double alpha = 1.0) const;
+
+        // Number of live tiles, including ones no longer visible
+        int size() const;
+
+        // Make *other* a copy of this pool, copying only the live tiles
+        void copyTo(TilePool &other) const;
+
+    private:
+        double mSpeed;
+        int mLeadHeight;
+
+        int mHead;
+        int mCount;
+
+        // still held while timeOff < timeOn, as with synth::note
+        std::vector<double> mTimeOn;
+        std::vector<double> mTimeOff;
+        std::vector<int> mY;
+        std::vector<int> mHeight;
+        std::vector<int> mPrevY;
+        std::vector<int> mPrevHeight;
+        std::vector<uint8_t> mLane;
+        std::vector<uint8_t> mColor;
+
+        void updateRange(int begin, int end, double dTime, int nHeight);
+};
+
+#endif // TILEPOOL_H
@@ -0,0 +1,56 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+/**
+ * Hands the latest copy of a value from one writer thread to one reader
+ * thread without locks and without either waiting on the other.
+ *
+ * The writer fills back() and publishes it; the reader calls update() and
+ * reads front(). Of the three slots one is always the writer's, one the
+ * reader's, and the third holds the newest published value, so a reader that
+ * falls behind simply skips to it and a writer never blocks.
+ */
+template<class T>
+class TripleBuffer {
+    public:
+        // Every slot starts as a copy of *initial*
+        explicit TripleBuffer(const T &initial) : mSlots{initial, initial, initial}, mMiddle(1), mBack(0), mFront(2) {}
+
+        // Writer: the slot to fill next; it keeps whatever was published from it last time
+        T &back() {
+            return mSlots[mBack];
+        }
+
+        // Writer: make back() the newest value and take another slot to fill
+        void publish() {
+            mBack = mMiddle.exchange(mBack | FRESH, std::memory_order_acq_rel) & INDEX;
+        }
+
+        // Reader: move to the newest value if one was published; false if front() is unchanged
+        bool update() {
+            if ((mMiddle.load(std::memory_order_relaxed) & FRESH) == 0) {
+                return false;
+            }
+            mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & INDEX;
+            return true;
+        }
+
+        // Reader: the value taken by the last update()
+        const T &front() const {
+            return mSlots[mFront];
+        }
+
+    private:
+        static const int INDEX = 3;
+        // set while the middle slot holds a value the reader has not taken
+        static const int FRESH = 4;
+
+        T mSlots[3];
+        std::atomic<int> mMiddle;
+        int mBack;
+        int mFront;
+};
+
+#endif // TRIPLEBUFFER_H
@@ -0,0 +1,82 @@
+#include "voiceslot.h"
+
+namespace synth {
+    voiceSlot::voiceSlot(instrument *initial, double dFadeTime /*= 0.01*/)
+        : dFadeTime(dFadeTime), pending(nullptr), latest(initial), current(initial), nRetireHead(0), nRetireTail(0) {}
+
+    voiceSlot::~voiceSlot() {
+        collect();
+        delete pending.exchange(nullptr);
+        delete previous;
+        delete current;
+    }
+
+    void voiceSlot::set(instrument *next) {
+        latest = next;
+        // if the audio thread never picked up the last one, it is still ours to delete
+        instrument *skipped = pending.exchange(next, std::memory_order_acq_rel);
+        delete skipped;
+    }
+
+    instrument *voiceSlot::get() const {
+        return latest;
+    }
+
+    void voiceSlot::collect() {
+        unsigned int nTail = nRetireTail.load(std::memory_order_relaxed);
+        unsigned int nHead = nRetireHead.load(std::memory_order_acquire);
+        while (nTail != nHead) {
+            delete retired[nTail % nRetireSize];
+            retired[nTail % nRetireSize] = nullptr;
+            ++nTail;
+        }
+        nRetireTail.store(nTail, std::memory_order_release);
+    }
+
+    bool voiceSlot::retire(instrument *old) {
+        unsigned int nHead = nRetireHead.load(std::memory_order_relaxed);
+        if (nHead - nRetireTail.load(std::memory_order_acquire) == nRetireSize) {
+            return false;
+        }
+        retired[nHead % nRetireSize] = old;
+        nRetireHead.store(nHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    void voiceSlot::update(double dTime) {
+        // the crossfade is over, hand the outgoing instrument back to the UI thread
+        if (previous != nullptr && dTime - dFadeStart >= dFadeTime && retire(previous)) {
+            previous = nullptr;
+        }
+
+        if (pending.load(std::memory_order_relaxed) == nullptr) {
+            return;
+        }
+        // a swap during a running crossfade drops the oldest instrument, so there
+        // must be room to retire it; otherwise try again on the next sample
+        if (previous != nullptr) {
+            if (!retire(previous)) {
+                return;
+            }
+            previous = nullptr;
+        }
+
+        instrument *next = pending.exchange(nullptr, std::memory_order_acquire);
+        if (next != nullptr) {
+            previous = current;
+            current = next;
+            dFadeStart = dTime;
+        }
+    }
+
+    double voiceSlot::sound(const note& n, double dTime) const {
+        double dOutput = current->sound(n, dTime);
+        if (previous != nullptr) {
+            double dBlend = (dTime - dFadeStart) / dFadeTime;
+            if (dBlend < 1.0) {
+                dOutput = dBlend * dOutput + (1.0 - dBlend) * previous->sound(n, dTime);
+            }
+        }
+        return dOutput;
+    }
+}
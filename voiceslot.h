@@ -0,0 +1,60 @@
+#ifndef VOICESLOT_H
+#define VOICESLOT_H
+
+#include <atomic>
+#include "synthesizer.h"
+
+namespace synth {
+    /**
+     * Holds the instrument the audio thread plays and lets the UI thread swap it
+     * while notes are sounding, without either side taking a lock.
+     *
+     * The UI thread hands over a new instrument with set(). The audio thread picks
+     * it up with a single atomic exchange in update() and crossfades from the old
+     * one. Instruments the audio thread is done with are passed back through a
+     * small ring and deleted by the UI thread in collect(), never on the audio thread.
+     */
+    class voiceSlot {
+    public:
+        // takes ownership of *initial*
+        voiceSlot(instrument *initial, double dFadeTime = 0.01);
+        // only safe once the audio thread has stopped
+        ~voiceSlot();
+
+        // UI thread: takes ownership of *next* and queues it for the audio thread
+        void set(instrument *next);
+        // UI thread: the instrument most recently set
+        instrument *get() const;
+        // UI thread: delete the instruments the audio thread has retired
+        void collect();
+
+        // Audio thread: call once per sample before sound()
+        void update(double dTime);
+        // Audio thread: the note played through the current instrument, blended
+        // with the outgoing one while a crossfade is running
+        double sound(const note& n, double dTime) const;
+
+    private:
+        static const unsigned int nRetireSize = 8;
+
+        double dFadeTime;
+
+        // written by the UI thread, taken by the audio thread
+        std::atomic<instrument*> pending;
+        // owned by the UI thread
+        instrument *latest;
+        // owned by the audio thread
+        instrument *current;
+        instrument *previous = nullptr;
+        double dFadeStart = 0.0;
+
+        // single-producer (audio) single-consumer (UI) ring of retired instruments
+        instrument *retired[nRetireSize] = {};
+        std::atomic<unsigned int> nRetireHead;
+        std::atomic<unsigned int> nRetireTail;
+
+        bool retire(instrument *old);
+    };
+}
+
+#endif // VOICESLOT_H